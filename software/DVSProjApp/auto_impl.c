@@ -0,0 +1,191 @@
+#include "auto_impl.h"
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "sw_impl.h"
+#include "hw_impl.h"
+
+// Model chooseScaler predicts with, set by loadCostModel and setCostModel
+static CostModel active;
+
+// Features of a region, each is a count of something one of the paths pays for
+// 0: calls, fixed cost of starting a path
+// 1: source pixels of the region
+// 2: source pixels on lines that reach the destination, HSCD and SW skip the other lines when downscaling
+// 3: destination pixels
+// 4: destination lines, per line cost of descriptors and loop setup
+// 5: destination pixels when source or destination lines are not word aligned, SW falls back to byte copies for those
+static void costFeatures(double* features, int misaligned, int width, int height, int destinationWidth, int destinationHeight, int yScale)
+{
+	double destinationPixels = (double)destinationWidth * destinationHeight;
+	features[0] = 1;
+	features[1] = (double)width * height;
+	features[2] = (double)width * (yScale < 0 ? destinationHeight : height);
+	features[3] = destinationPixels;
+	features[4] = destinationHeight;
+	features[5] = misaligned ? destinationPixels : 0;
+}
+
+int costMisaligned(unsigned char* source, int sourceWidth, int x, int y, unsigned char* destination, int destinationWidth)
+{
+	// Every line starts aligned only when the first one does and the strides are whole words
+	uintptr_t first = (uintptr_t)&source[x + y * sourceWidth];
+	return ((first | (uintptr_t)sourceWidth | (uintptr_t)destination | (uintptr_t)destinationWidth) & 3) != 0;
+}
+
+// Solve a COST_TERMS x COST_TERMS system by Gaussian elimination with partial pivoting, returns 1 when it is singular
+static int solve(double a[COST_TERMS][COST_TERMS], double* b, double* x)
+{
+	for (int i = 0; i < COST_TERMS; i++)
+	{
+		int pivot = i;
+		for (int j = i + 1; j < COST_TERMS; j++) { if (a[j][i] * a[j][i] > a[pivot][i] * a[pivot][i]) { pivot = j; } }
+		if (a[pivot][i] == 0) { return 1; }
+
+		for (int k = 0; k < COST_TERMS; k++) { double t = a[i][k]; a[i][k] = a[pivot][k]; a[pivot][k] = t; }
+		double t = b[i]; b[i] = b[pivot]; b[pivot] = t;
+
+		for (int j = i + 1; j < COST_TERMS; j++)
+		{
+			double f = a[j][i] / a[i][i];
+			for (int k = i; k < COST_TERMS; k++) { a[j][k] -= f * a[i][k]; }
+			b[j] -= f * b[i];
+		}
+	}
+
+	for (int i = COST_TERMS - 1; i >= 0; i--)
+	{
+		double s = b[i];
+		for (int k = i + 1; k < COST_TERMS; k++) { s -= a[i][k] * x[k]; }
+		x[i] = s / a[i][i];
+	}
+	return 0;
+}
+
+void fitCostModel(CostModel* model, CostSample* samples, int count)
+{
+	for (int p = 0; p < AUTO_PATHS; p++)
+	{
+		double a[COST_TERMS][COST_TERMS] = {{0}};
+		double b[COST_TERMS] = {0};
+		double scale[COST_TERMS] = {0};
+		double features[COST_TERMS];
+		int used = 0;
+
+		// Every measurement is divided by its time so that small regions count as much as large ones
+		// Features are normalized to their largest value first, they differ by many orders of magnitude
+		for (int i = 0; i < count; i++)
+		{
+			CostSample* s = &samples[i];
+			if (s->time[p] <= 0) { continue; }
+			costFeatures(features, s->misaligned, s->width, s->height, s->destinationWidth, s->destinationHeight, s->yScale);
+			for (int k = 0; k < COST_TERMS; k++) { if (features[k] / s->time[p] > scale[k]) { scale[k] = features[k] / s->time[p]; } }
+		}
+		for (int k = 0; k < COST_TERMS; k++) { if (scale[k] == 0) { scale[k] = 1; } }
+
+		for (int i = 0; i < count; i++)
+		{
+			CostSample* s = &samples[i];
+			if (s->time[p] <= 0) { continue; }
+			costFeatures(features, s->misaligned, s->width, s->height, s->destinationWidth, s->destinationHeight, s->yScale);
+			for (int k = 0; k < COST_TERMS; k++) { features[k] /= s->time[p] * scale[k]; }
+			for (int j = 0; j < COST_TERMS; j++)
+			{
+				for (int k = 0; k < COST_TERMS; k++) { a[j][k] += features[j] * features[k]; }
+				b[j] += features[j];
+			}
+			used++;
+		}
+		if (used == 0) { continue; }
+
+		// Small ridge term keeps terms that no measurement tells apart from making the system singular
+		for (int k = 0; k < COST_TERMS; k++) { a[k][k] += 1e-9 * used; }
+
+		double x[COST_TERMS];
+		if (solve(a, b, x)) { continue; }
+
+		model->path[p].valid = 1;
+		for (int k = 0; k < COST_TERMS; k++) { model->path[p].coefficients[k] = x[k] / scale[k]; }
+	}
+}
+
+int loadCostModel(char* fname)
+{
+	CostModel loaded;
+
+	FILE* f = fopen(fname, "r");
+	if (f == NULL) { return 1; }
+
+	for (int p = 0; p < AUTO_PATHS; p++)
+	{
+		loaded.path[p].valid = 1;
+		for (int k = 0; k < COST_TERMS; k++)
+		{
+			if (fscanf(f, "%f", &loaded.path[p].coefficients[k]) != 1) { fclose(f); return 2; }
+		}
+	}
+
+	fclose(f);
+
+	active = loaded;
+	return 0;
+}
+
+void setCostModel(CostModel* model)
+{
+	active = *model;
+}
+
+int saveCostModel(CostModel* model, char* fname)
+{
+	FILE* f = fopen(fname, "w");
+	if (f == NULL) { return 1; }
+
+	for (int p = 0; p < AUTO_PATHS; p++)
+	{
+		for (int k = 0; k < COST_TERMS; k++)
+		{
+			fprintf(f, k == 0 ? "%e" : " %e", model->path[p].valid ? model->path[p].coefficients[k] : 0.0f);
+		}
+		fprintf(f, "\n");
+	}
+
+	fclose(f);
+	return 0;
+}
+
+float predictCost(int path, int misaligned, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	if (!active.path[path].valid) { return -1; }
+
+	double features[COST_TERMS];
+	costFeatures(features, misaligned, width, height, destinationWidth, destinationHeight, yScale);
+
+	float cost = 0;
+	for (int k = 0; k < COST_TERMS; k++) { cost += active.path[path].coefficients[k] * (float)features[k]; }
+
+	// Fitted models can go slightly negative for the smallest regions
+	return cost > 0 ? cost : 0;
+}
+
+int chooseScaler(int misaligned, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	int best = AUTO_HSCD;
+	float bestCost = -1;
+	for (int p = 0; p < AUTO_PATHS; p++)
+	{
+		float cost = predictCost(p, misaligned, width, height, destinationWidth, destinationHeight, xScale, yScale);
+		if (cost >= 0 && (bestCost < 0 || cost < bestCost)) { best = p; bestCost = cost; }
+	}
+	return best;
+}
+
+void scaleAuto(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	int misaligned = costMisaligned(source, sourceWidth, x, y, destination, destinationWidth);
+	int path = chooseScaler(misaligned, width, height, destinationWidth, destinationHeight, xScale, yScale);
+	if (path == AUTO_SW)      { scaleSW(source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+	else if (path == AUTO_HW) { scaleHW(ctx, source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+	else                      { scaleHSCD(ctx, source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+}
@@ -0,0 +1,66 @@
+#ifndef AUTO_IMPL_H_
+#define AUTO_IMPL_H_
+
+#include "hw_impl.h"
+
+// Scalers scaleAuto chooses from
+#define AUTO_SW 0
+#define AUTO_HW 1
+#define AUTO_HSCD 2
+#define AUTO_PATHS 3
+
+// Number of terms of the cost model, see costFeatures in auto_impl.c
+#define COST_TERMS 6
+
+// One benchmark measurement, times are in seconds and negative for paths that were not measured
+typedef struct
+{
+	int misaligned;
+	int width;
+	int height;
+	int destinationWidth;
+	int destinationHeight;
+	int xScale;
+	int yScale;
+	double time[AUTO_PATHS];
+} CostSample;
+
+// Cost model is linear in features of the region, one set of coefficients per path
+// Single precision is enough for predictions and cheap on a CPU without FPU, fitting is done in double
+typedef struct
+{
+	int valid;
+	float coefficients[COST_TERMS];
+} CostPath;
+
+typedef struct
+{
+	CostPath path[AUTO_PATHS];
+} CostModel;
+
+// Fit model to measurements by least squares on relative error, paths without measurements keep what model had
+// Fitting does not change the model chooseScaler uses, pass the result to setCostModel for that
+void fitCostModel(CostModel* model, CostSample* samples, int count);
+
+// Make a copy of model the one chooseScaler and predictCost use
+void setCostModel(CostModel* model);
+
+// Text file with one line of COST_TERMS coefficients per path, in the order of AUTO_SW, AUTO_HW and AUTO_HSCD
+// Load reads into the model chooseScaler uses and returns 0 on success, on failure that model is kept
+int loadCostModel(char* fname);
+int saveCostModel(CostModel* model, char* fname);
+
+// 1 when a source line of the region or a destination line does not start on a word boundary, the misaligned argument of the functions below
+// Source lines are sourceWidth bytes apart and destination lines destinationWidth bytes apart
+int costMisaligned(unsigned char* source, int sourceWidth, int x, int y, unsigned char* destination, int destinationWidth);
+
+// Predicted time of one path in seconds, negative when there is no model for it or the path does not apply
+float predictCost(int path, int misaligned, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+
+// Path with the lowest predicted time, scaleHSCD when no model is loaded
+int chooseScaler(int misaligned, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+
+// Same as scaleHW, but runs the region through the path chosen by chooseScaler
+void scaleAuto(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+
+#endif /* AUTO_IMPL_H_ */
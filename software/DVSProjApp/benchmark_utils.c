@@ -3,20 +3,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <system.h>
+#include <io.h>
 #include <altera_avalon_performance_counter.h>
 #include <sys/alt_cache.h>
 
 #include "sw_impl.h"
 #include "hw_impl.h"
+#include "hybrid_impl.h"
+#include "auto_impl.h"
+#include "image_alloc.h"
 
 #define MAX_PATH 256
 
 #define BENCH_CASES 8
 #define TEST_CASES 50
 #define TEST_REPEATS 3
+#define TEST_WARMUP 0
 #define WRITE_RESULT 1
 
+// Image sizes of the sweep, powers of two and the odd size below each of them
+#define SWEEP_SIZES 13
+
 #define RAND_INC_EXC(l, h) ((l) + ( rand() % ((h) - (l))))
 
 typedef struct
@@ -27,8 +36,15 @@ typedef struct
 	int h;
 	int xScale;
 	int yScale;
-	int ok[3 * TEST_REPEATS];
-	alt_u64 times[3 * TEST_REPEATS];
+	// Alignment of the buffers the case ran on, for the cost model
+	int misaligned;
+	// SW, HW and HSCD error counts and times of every repeat, 3 * repeats entries taken from the arena
+	int* ok;
+	alt_u64* times;
+	// Driver phase times of HW and then HSCD, summed over the recorded repeats
+	// Repeats that failed with a hardware error are not recorded, so they are counted separately
+	alt_u64 phases[2 * HW_PERF_PHASES];
+	int phaseRepeats;
 } TestCase;
 
 int verify(unsigned char* reference, unsigned char* target, int size)
@@ -90,12 +106,15 @@ void submitTimes(TestCase* test, int repeat)
 	test->times[repeat * 3 + 0] = perf_get_section_time(PERF_CNT_BASE, 1);
 	test->times[repeat * 3 + 1] = perf_get_section_time(PERF_CNT_BASE, 2);
 	test->times[repeat * 3 + 2] = perf_get_section_time(PERF_CNT_BASE, 3);
+
+	// Measured throughputs decide how scaleHybrid splits later runs with the same factors
+	hybridRecord(test->xScale, test->yScale, test->times[repeat * 3 + 0], test->times[repeat * 3 + 1], test->times[repeat * 3 + 2]);
 }
 
 int writeImage(char* fname, unsigned char* destinationImage, int destinationWidth, int destinationHeight)
 {
 	// Prepared path to access hostfs and move to root dir
-	char ffname[MAX_PATH] = "/mnt/host/../../";
+	char ffname[MAX_PATH] = HOSTFS_ROOT;
 	// Append entered filename
 	strcat(ffname, fname);
 
@@ -129,6 +148,42 @@ int writeImage(char* fname, unsigned char* destinationImage, int destinationWidt
 	return 0;
 }
 
+// Section time read without stopping the counter, perf_get_section_time would stop it and with it every section of the next run
+// The high word is read again to catch a carry out of the low word in between
+alt_u64 readSection(int section)
+{
+	alt_u32 hi;
+	alt_u32 lo;
+	do
+	{
+		hi = IORD(PERF_CNT_BASE, section * 4 + 1);
+		lo = IORD(PERF_CNT_BASE, section * 4);
+	} while (hi != IORD(PERF_CNT_BASE, section * 4 + 1));
+	return (alt_u64)hi << 32 | lo;
+}
+
+void readPhases(alt_u64* phases)
+{
+	for (int p = 0; p < HW_PERF_PHASES; p++)
+	{
+		phases[p] = HW_PERF_FIRST_SECTION > 0 ? readSection(HW_PERF_FIRST_SECTION + p) : 0;
+	}
+}
+
+// Sections are reset before every repeat, so the HSCD phases are what was added after the HW run
+void submitPhases(TestCase* test, alt_u64* hwPhases)
+{
+	alt_u64 phases[HW_PERF_PHASES];
+	readPhases(phases);
+
+	for (int p = 0; p < HW_PERF_PHASES; p++)
+	{
+		test->phases[p]                  += hwPhases[p];
+		test->phases[HW_PERF_PHASES + p] += phases[p] - hwPhases[p];
+	}
+	test->phaseRepeats++;
+}
+
 void writeResult(TestCase* test, char* fname, unsigned char* destinationImage, int destinationWidth, int destinationHeight)
 {
 	char fileNameNoExt[MAX_PATH];
@@ -146,14 +201,78 @@ void writeResult(TestCase* test, char* fname, unsigned char* destinationImage, i
 	if (writeImage(fileName, destinationImage, destinationWidth, destinationHeight)){ printf("Failed to write result\n"); }
 }
 
-void runTests(TestCase* tests, HWContext* ctx, char* fname, unsigned char* source, int width, int height)
+// Run one test case warmup times and then repeats times on SW, HW and HSCD, recording times and verification results
+void runTest(TestCase* test, HWContext* ctx, unsigned char* source, int stride, int height, unsigned char* referenceImage, unsigned char* destinationImage, int warmup, int repeats)
+{
+	// Calculate destination image dimensions
+	int destinationWidth  = test->xScale > 0 ? test->w * test->xScale : (test->w - test->xScale - 1) / -test->xScale;
+	int destinationHeight = test->yScale > 0 ? test->h * test->yScale : (test->h - test->yScale - 1) / -test->yScale;
+
+	// Alignment the software scaler sees, it writes the reference image
+	test->misaligned = costMisaligned(source, stride, test->x, test->y, referenceImage, destinationWidth);
+
+	// Warmup runs have negative indices, they are verified against nothing and their results are dropped
+	for (int j = -warmup; j < repeats; j++)
+	{
+		// Reset and restart performance counter
+		PERF_RESET(PERF_CNT_BASE);
+		PERF_START_MEASURING(PERF_CNT_BASE);
+
+		// Flush cache so the software scaler starts cold and start measuring time
+		alt_dcache_flush_all();
+		PERF_BEGIN(PERF_CNT_BASE, 1);
+
+		// Run software scaler
+		scaleSW(source, referenceImage, stride, height, test->x, test->y, test->w, test->h, destinationWidth, destinationHeight, test->xScale, test->yScale);
+
+		PERF_END(PERF_CNT_BASE, 1);
+
+		// Verify and submit the result
+		if (j >= 0) { submitResult(test, j, 0, referenceImage, destinationImage, destinationWidth * destinationHeight); }
+
+		// Start measuring time, the driver maintains the cache for the lines it transfers
+		PERF_BEGIN(PERF_CNT_BASE, 2);
+
+		// Run hardware scaler
+		scaleHW(ctx, source, destinationImage, stride, height, test->x, test->y, test->w, test->h, destinationWidth, destinationHeight, test->xScale, test->yScale);
+
+		PERF_END(PERF_CNT_BASE, 2);
+
+		// Driver phases so far belong to the hardware scaler, the counter keeps running for the HSCD run
+		alt_u64 hwPhases[HW_PERF_PHASES];
+		readPhases(hwPhases);
+
+		// Verify and submit the result, a failed context is set up again for the remaining runs
+		if (checkHW(ctx)) { printf("Hardware error\n"); initHW(ctx); continue; }
+		if (j >= 0) { submitResult(test, j, 1, referenceImage, destinationImage, destinationWidth * destinationHeight); }
+
+		// Start measuring time, the driver maintains the cache for the lines it transfers
+		PERF_BEGIN(PERF_CNT_BASE, 3);
+
+		// Run hardware/software scaler
+		scaleHSCD(ctx, source, destinationImage, stride, height, test->x, test->y, test->w, test->h, destinationWidth, destinationHeight, test->xScale, test->yScale);
+
+		PERF_END(PERF_CNT_BASE, 3);
+
+		// Verify and submit the result0
+		if (checkHW(ctx)) { printf("Hardware error\n"); initHW(ctx); continue; }
+		if (j >= 0) { submitResult(test, j, 2, referenceImage, destinationImage, destinationWidth * destinationHeight); }
+
+		// Submit times
+		if (j >= 0) { submitTimes(test, j); }
+		if (j >= 0) { submitPhases(test, hwPhases); }
+	}
+}
+
+void runTests(TestCase* tests, HWContext* ctx, ImageArena* arena, char* fname, unsigned char* source, int stride, int width, int height, int warmup, int repeats)
 {
 	// Calculate maximum image size and add one byte for each test case, then allocate two buffers of that size
 	int destinationSize = (4 * width * 4 * height) + (BENCH_CASES + TEST_CASES);
 
-	// Allocate two buffers for destination image, one for software and one for hardware scaling
-	unsigned char* referenceImage   = malloc(sizeof(unsigned char) * destinationSize);
-	unsigned char* destinationImage = malloc(sizeof(unsigned char) * destinationSize);
+	// Take two buffers for destination image from the arena, one for software and one for hardware scaling
+	// They are released together with the source image once the benchmark command is done
+	unsigned char* referenceImage   = arenaAlloc(arena, sizeof(unsigned char) * destinationSize, 0);
+	unsigned char* destinationImage = arenaAlloc(arena, sizeof(unsigned char) * destinationSize, 1);
 
 	if (referenceImage   == NULL) { printf("Failed to allocate output buffer\n"); return; }
 	if (destinationImage == NULL) { printf("Failed to allocate output buffer\n"); return; }
@@ -168,90 +287,208 @@ void runTests(TestCase* tests, HWContext* ctx, char* fname, unsigned char* sourc
 		int destinationWidth  = test->xScale > 0 ? test->w * test->xScale : (test->w - test->xScale - 1) / -test->xScale;
 		int destinationHeight = test->yScale > 0 ? test->h * test->yScale : (test->h - test->yScale - 1) / -test->yScale;
 
-		for (int j = 0; j < TEST_REPEATS; j++)
+		runTest(test, ctx, source, stride, height, referenceImage, destinationImage, warmup, repeats);
+
+		printf("\n");
+
+		if (WRITE_RESULT)
 		{
-			// Reset and restart performance counter
-			PERF_RESET(PERF_CNT_BASE);
-			PERF_START_MEASURING(PERF_CNT_BASE);
+			writeResult(test, fname, destinationImage, destinationWidth, destinationHeight);
+		}
+	}
+}
 
-			// Flush cache and start measuring time
-			alt_dcache_flush_all();
-			PERF_BEGIN(PERF_CNT_BASE, 1);
+void writeResults(TestCase* tests, unsigned int seed, int repeats)
+{
+	char fname[MAX_PATH];
 
-			// Run software scaler
-			scaleSW(source, referenceImage, width, height, test->x, test->y, test->w, test->h, destinationWidth, destinationHeight, test->xScale, test->yScale);
+	printf("Writing results to benchmark_%u.csv\n", seed);
+	sprintf(fname, HOSTFS_ROOT "benchmark_%u.csv", seed);
 
-			PERF_END(PERF_CNT_BASE, 1);
+	FILE* f = fopen(fname, "w");
+	if (f == NULL) { printf("Failed to open output file\n"); return; }
 
-			// Verify and submit the result
-			submitResult(test, j, 0, referenceImage, destinationImage, destinationWidth * destinationHeight);
+	for (int i = 0; i < (BENCH_CASES + TEST_CASES); i++)
+	{
+		TestCase* test = &tests[i];
 
-			// Flush cache and start measuring time
-			alt_dcache_flush_all();
-			PERF_BEGIN(PERF_CNT_BASE, 2);
+		fprintf(f, "%d,%d,%d,%d,%d,%d", test->x, test->y, test->w, test->h, test->xScale, test->yScale);
 
-			// Run hardware scaler
-			scaleHW(ctx, source, destinationImage, width, height, test->x, test->y, test->w, test->h, destinationWidth, destinationHeight, test->xScale, test->yScale);
+		for (int j = 0; j < 3 * repeats; j++)
+		{
+			fprintf(f, ",%f", (float)test->times[j] / (float)ALT_CPU_FREQ);
+		}
 
-			PERF_END(PERF_CNT_BASE, 2);
+		for (int j = 0; j < 3 * repeats; j++)
+		{
+			fprintf(f, ",%d", test->ok[j]);
+		}
 
-			// Verify and submit the result
-			if (checkHW(ctx)) {  printf("Hardware error\n"); continue; }
-			submitResult(test, j, 1, referenceImage, destinationImage, destinationWidth * destinationHeight);
+		fprintf(f,"\n");
+	}
 
-			// Flush cache and start measuring time
-			alt_dcache_flush_all();
-			PERF_BEGIN(PERF_CNT_BASE, 3);
+	fclose(f);
+}
 
-			// Run hardware/software scaler
-			scaleHSCD(ctx, source, destinationImage, width, height, test->x, test->y, test->w, test->h, destinationWidth, destinationHeight, test->xScale, test->yScale);
+int compareTimes(const void* a, const void* b)
+{
+	alt_u64 ta = *(const alt_u64*)a;
+	alt_u64 tb = *(const alt_u64*)b;
+	return (ta > tb) - (ta < tb);
+}
 
-			PERF_END(PERF_CNT_BASE, 3);
+// Statistics of the verified runs of one implementation, times in CPU cycles, all 0 when no run passed verification
+typedef struct
+{
+	double min;
+	double median;
+	double p95;
+	double max;
+	double mean;
+	double deviation;
+	int failed;
+} TestStats;
+
+void summarizeTimes(TestCase* test, int idx, int repeats, alt_u64* sorted, TestStats* stats)
+{
+	int n = 0;
+	for (int j = 0; j < repeats; j++)
+	{
+		if (test->ok[j * 3 + idx] == 0) { sorted[n++] = test->times[j * 3 + idx]; }
+	}
+	qsort(sorted, n, sizeof(alt_u64), compareTimes);
+
+	memset(stats, 0, sizeof(TestStats));
+	stats->failed = repeats - n;
+	if (n == 0) { return; }
+
+	for (int j = 0; j < n; j++) { stats->mean += sorted[j]; }
+	stats->mean /= n;
+	for (int j = 0; j < n; j++) { stats->deviation += (sorted[j] - stats->mean) * (sorted[j] - stats->mean); }
+	stats->deviation = n > 1 ? sqrt(stats->deviation / (n - 1)) : 0;
+
+	// Median averages the two middle samples of an even count, p95 is the nearest rank
+	stats->min    = sorted[0];
+	stats->median = (n % 2) ? (double)sorted[n / 2] : ((double)sorted[n / 2 - 1] + (double)sorted[n / 2]) / 2;
+	stats->p95    = sorted[(95 * n + 99) / 100 - 1];
+	stats->max    = sorted[n - 1];
+}
 
-			// Verify and submit the result0
-			if (checkHW(ctx)) {  printf("Hardware error\n"); continue; }
-			submitResult(test, j, 2, referenceImage, destinationImage, destinationWidth * destinationHeight);
+void writeStatistics(TestCase* tests, unsigned int seed, int repeats, alt_u64* sorted)
+{
+	char fname[MAX_PATH];
 
-			// Submit times
-			submitTimes(test, j);
-		}
+	printf("Writing statistics to benchmark_%u_stats.csv\n", seed);
+	sprintf(fname, HOSTFS_ROOT "benchmark_%u_stats.csv", seed);
 
-		printf("\n");
+	FILE* f = fopen(fname, "w");
+	if (f == NULL) { printf("Failed to open output file\n"); return; }
 
-		if (WRITE_RESULT)
+	// One line per test case, then min, median, p95, max, mean and standard deviation in seconds and the failed run count of SW, HW and HSCD
+	for (int i = 0; i < (BENCH_CASES + TEST_CASES); i++)
+	{
+		TestCase* test = &tests[i];
+
+		fprintf(f, "%d,%d,%d,%d,%d,%d", test->x, test->y, test->w, test->h, test->xScale, test->yScale);
+
+		for (int idx = 0; idx < 3; idx++)
 		{
-			writeResult(test, fname, destinationImage, destinationWidth, destinationHeight);
+			TestStats stats;
+			summarizeTimes(test, idx, repeats, sorted, &stats);
+
+			fprintf(f, ",%f,%f,%f,%f,%f,%f,%d",
+				stats.min       / ALT_CPU_FREQ,
+				stats.median    / ALT_CPU_FREQ,
+				stats.p95       / ALT_CPU_FREQ,
+				stats.max       / ALT_CPU_FREQ,
+				stats.mean      / ALT_CPU_FREQ,
+				stats.deviation / ALT_CPU_FREQ,
+				stats.failed);
 		}
+
+		fprintf(f,"\n");
 	}
 
-	free(referenceImage);
-	free(destinationImage);
+	fclose(f);
 }
 
-void writeResults(TestCase* tests, unsigned int seed)
+void writeThroughput(TestCase* tests, unsigned int seed, int repeats, alt_u64* sorted)
 {
 	char fname[MAX_PATH];
 
-	printf("Writing results to benchmark_%u.csv\n", seed);
-	sprintf(fname, "/mnt/host/../../benchmark_%u.csv", seed);
+	printf("Writing throughput to benchmark_%u_throughput.csv\n", seed);
+	sprintf(fname, HOSTFS_ROOT "benchmark_%u_throughput.csv", seed);
 
 	FILE* f = fopen(fname, "w");
 	if (f == NULL) { printf("Failed to open output file\n"); return; }
 
+	// One line per test case, then source and destination pixels per CPU cycle, bytes read and written per second of SW, HW and HSCD
+	// followed by the speedup of HW and HSCD over SW, all from median times
+	// Bandwidth counts each region pixel read once and each destination pixel written once, whatever the implementation actually moves
 	for (int i = 0; i < (BENCH_CASES + TEST_CASES); i++)
 	{
 		TestCase* test = &tests[i];
 
+		int destinationWidth  = test->xScale > 0 ? test->w * test->xScale : (test->w - test->xScale - 1) / -test->xScale;
+		int destinationHeight = test->yScale > 0 ? test->h * test->yScale : (test->h - test->yScale - 1) / -test->yScale;
+		double sourcePixels      = (double)test->w * test->h;
+		double destinationPixels = (double)destinationWidth * destinationHeight;
+
 		fprintf(f, "%d,%d,%d,%d,%d,%d", test->x, test->y, test->w, test->h, test->xScale, test->yScale);
 
-		for (int j = 0; j < 3 * TEST_REPEATS; j++)
+		double median[3];
+		for (int idx = 0; idx < 3; idx++)
 		{
-			fprintf(f, ",%f", (float)test->times[j] / (float)ALT_CPU_FREQ);
+			TestStats stats;
+			summarizeTimes(test, idx, repeats, sorted, &stats);
+			median[idx] = stats.median;
+
+			if (median[idx] > 0)
+			{
+				fprintf(f, ",%f,%f,%.0f,%.0f",
+					sourcePixels      / median[idx],
+					destinationPixels / median[idx],
+					sourcePixels      * ALT_CPU_FREQ / median[idx],
+					destinationPixels * ALT_CPU_FREQ / median[idx]);
+			}
+			else
+			{
+				fprintf(f, ",0,0,0,0");
+			}
 		}
 
-		for (int j = 0; j < 3 * TEST_REPEATS; j++)
+		fprintf(f, ",%f,%f",
+			median[1] > 0 ? median[0] / median[1] : 0,
+			median[2] > 0 ? median[0] / median[2] : 0);
+
+		fprintf(f,"\n");
+	}
+
+	fclose(f);
+}
+
+void writePhases(TestCase* tests, unsigned int seed)
+{
+	char fname[MAX_PATH];
+
+	printf("Writing driver phases to benchmark_%u_phases.csv\n", seed);
+	sprintf(fname, HOSTFS_ROOT "benchmark_%u_phases.csv", seed);
+
+	FILE* f = fopen(fname, "w");
+	if (f == NULL) { printf("Failed to open output file\n"); return; }
+
+	// One line per test case, then mean prepare, start and wait times in seconds of HW and then HSCD
+	// Means are taken over the recorded repeats, -1 when every repeat of the case failed
+	// Compared with the total time they show whether a run was limited by preparing passes or by the stream
+	for (int i = 0; i < (BENCH_CASES + TEST_CASES); i++)
+	{
+		TestCase* test = &tests[i];
+
+		fprintf(f, "%d,%d,%d,%d,%d,%d", test->x, test->y, test->w, test->h, test->xScale, test->yScale);
+
+		for (int p = 0; p < 2 * HW_PERF_PHASES; p++)
 		{
-			fprintf(f, ",%d", test->ok[j]);
+			fprintf(f, ",%f", test->phaseRepeats > 0 ? (double)test->phases[p] / test->phaseRepeats / ALT_CPU_FREQ : -1);
 		}
 
 		fprintf(f,"\n");
@@ -260,17 +497,185 @@ void writeResults(TestCase* tests, unsigned int seed)
 	fclose(f);
 }
 
-void benchmark(HWContext* ctx, char* fname, unsigned char* source, int width, int height)
+void writeModel(TestCase* tests, unsigned int seed, int repeats, CostSample* samples)
+{
+	char fname[MAX_PATH];
+	// Fitted on its own, the model scaleAuto uses stays the one that was loaded
+	CostModel model = {0};
+
+	// Every repeat is a measurement, results that failed verification are left out
+	for (int i = 0; i < (BENCH_CASES + TEST_CASES); i++)
+	{
+		TestCase* test = &tests[i];
+		for (int j = 0; j < repeats; j++)
+		{
+			CostSample* s = &samples[i * repeats + j];
+			s->misaligned        = test->misaligned;
+			s->width             = test->w;
+			s->height            = test->h;
+			s->destinationWidth  = test->xScale > 0 ? test->w * test->xScale : (test->w - test->xScale - 1) / -test->xScale;
+			s->destinationHeight = test->yScale > 0 ? test->h * test->yScale : (test->h - test->yScale - 1) / -test->yScale;
+			s->xScale            = test->xScale;
+			s->yScale            = test->yScale;
+			for (int p = 0; p < AUTO_PATHS; p++)
+			{
+				s->time[p] = test->ok[j * 3 + p] == 0 ? (double)test->times[j * 3 + p] / ALT_CPU_FREQ : -1;
+			}
+		}
+	}
+
+	fitCostModel(&model, samples, (BENCH_CASES + TEST_CASES) * repeats);
+
+	printf("Writing cost model to benchmark_%u.model\n", seed);
+	sprintf(fname, HOSTFS_ROOT "benchmark_%u.model", seed);
+	if (saveCostModel(&model, fname)) { printf("Failed to open output file\n"); }
+}
+
+void benchmark(HWContext* ctx, ImageArena* arena, char* fname, unsigned char* source, int stride, int width, int height, int warmup, int repeats)
 {
 	TestCase testCases[BENCH_CASES + TEST_CASES];
 
+	// Zero repeats select the defaults
+	if (repeats == 0) { warmup = TEST_WARMUP; repeats = TEST_REPEATS; }
+
+	// Times and error counts of all repeats, runs that never finished stay marked as failed
+	int cases = BENCH_CASES + TEST_CASES;
+	int* ok             = (int*)arenaAlloc(arena, sizeof(int) * cases * 3 * repeats, 0);
+	alt_u64* times      = (alt_u64*)arenaAlloc(arena, sizeof(alt_u64) * cases * 3 * repeats, 0);
+	alt_u64* sorted     = (alt_u64*)arenaAlloc(arena, sizeof(alt_u64) * repeats, 0);
+	CostSample* samples = (CostSample*)arenaAlloc(arena, sizeof(CostSample) * cases * repeats, 0);
+	if (ok == NULL || times == NULL || sorted == NULL || samples == NULL) { printf("Failed to allocate benchmark results\n"); return; }
+
+	for (int i = 0; i < cases; i++)
+	{
+		testCases[i].ok    = &ok[i * 3 * repeats];
+		testCases[i].times = &times[i * 3 * repeats];
+		memset(testCases[i].phases, 0, sizeof(testCases[i].phases));
+		testCases[i].phaseRepeats = 0;
+	}
+	for (int i = 0; i < cases * 3 * repeats; i++) { ok[i] = -1; times[i] = 0; }
+
 	unsigned int seed = perf_get_total_time(PERF_CNT_BASE);
 
-	printf("Starting benchmark, seed: %u\n", seed);
+	printf("Starting benchmark, seed: %u, warmup: %d, repeats: %d\n", seed, warmup, repeats);
 
 	generateTests(testCases, width, height, seed);
 
-	runTests(testCases, ctx, fname, source, width, height);
+	runTests(testCases, ctx, arena, fname, source, stride, width, height, warmup, repeats);
+
+	writeResults(testCases, seed, repeats);
+
+	writeStatistics(testCases, seed, repeats, sorted);
+
+	writeThroughput(testCases, seed, repeats, sorted);
+
+	if (HW_PERF_FIRST_SECTION > 0) { writePhases(testCases, seed); }
+
+	writeModel(testCases, seed, repeats, samples);
+}
+
+void sweep(HWContext* ctx, ImageArena* arena, char* fname, int maxSize, int repeats)
+{
+	int sizes[SWEEP_SIZES] = {16, 31, 32, 63, 64, 127, 128, 255, 256, 511, 512, 1023, 1024};
+	int validScales[] = {-4, -3, -2, -1, 1, 2, 3, 4};
+
+	// Zero repeats select the default
+	if (repeats == 0) { repeats = TEST_REPEATS; }
+
+	// One synthesized source image at a time, laid out with the stride of its own width, and destinations for the largest upscale
+	int destinationSize = 4 * maxSize * 4 * maxSize;
+	unsigned char* source           = arenaAlloc(arena, sizeof(unsigned char) * imageStride(maxSize) * maxSize, 0);
+	unsigned char* referenceImage   = arenaAlloc(arena, sizeof(unsigned char) * destinationSize, 0);
+	unsigned char* destinationImage = arenaAlloc(arena, sizeof(unsigned char) * destinationSize, 1);
+	int* ok                         = (int*)arenaAlloc(arena, sizeof(int) * 3 * repeats, 0);
+	alt_u64* times                  = (alt_u64*)arenaAlloc(arena, sizeof(alt_u64) * 3 * repeats, 0);
+	alt_u64* sorted                 = (alt_u64*)arenaAlloc(arena, sizeof(alt_u64) * repeats, 0);
+	if (source == NULL || referenceImage == NULL || destinationImage == NULL || ok == NULL || times == NULL || sorted == NULL) { printf("Failed to allocate sweep buffers\n"); return; }
+
+	char ffname[MAX_PATH] = HOSTFS_ROOT;
+	strcat(ffname, fname);
+
+	FILE* f = fopen(ffname, "w");
+	if (f == NULL) { printf("Failed to open output file\n"); return; }
+
+	// Smallest image, by pixel count, on which HW or HSCD beat SW, per scaling factor pair, and which of the two it was
+	int crossoverWidth[8][8];
+	int crossoverHeight[8][8];
+	int crossoverHSCD[8][8];
+	memset(crossoverWidth, 0, sizeof(crossoverWidth));
+	memset(crossoverHeight, 0, sizeof(crossoverHeight));
+	memset(crossoverHSCD, 0, sizeof(crossoverHSCD));
+
+	printf("Starting sweep up to %d x %d, repeats: %d\n", maxSize, maxSize, repeats);
+
+	// One line per image size and scaling factor pair, then median SW, HW and HSCD times in seconds and the number of failed runs
+	srand(0);
+	for (int hi = 0; hi < SWEEP_SIZES && sizes[hi] <= maxSize; hi++)
+	{
+		for (int wi = 0; wi < SWEEP_SIZES && sizes[wi] <= maxSize; wi++)
+		{
+			int width  = sizes[wi];
+			int height = sizes[hi];
+			int stride = imageStride(width);
+
+			for (int i = 0; i < stride * height; i++) { source[i] = rand(); }
+
+			printf("Sweeping %d x %d\n", width, height);
+
+			for (int xi = 0; xi < 8; xi++)
+			{
+				for (int yi = 0; yi < 8; yi++)
+				{
+					TestCase test;
+					test.x      = 0;
+					test.y      = 0;
+					test.w      = width;
+					test.h      = height;
+					test.xScale = validScales[xi];
+					test.yScale = validScales[yi];
+					test.ok     = ok;
+					test.times  = times;
+					memset(test.phases, 0, sizeof(test.phases));
+					test.phaseRepeats = 0;
+					for (int i = 0; i < 3 * repeats; i++) { ok[i] = -1; times[i] = 0; }
+
+					runTest(&test, ctx, source, stride, height, referenceImage, destinationImage, 0, repeats);
+					printf("\n");
+
+					TestStats stats[3];
+					int failed = 0;
+					for (int idx = 0; idx < 3; idx++)
+					{
+						summarizeTimes(&test, idx, repeats, sorted, &stats[idx]);
+						failed += stats[idx].failed;
+					}
+
+					fprintf(f, "%d,%d,%d,%d,%f,%f,%f,%d\n", width, height, test.xScale, test.yScale,
+						stats[0].median / ALT_CPU_FREQ, stats[1].median / ALT_CPU_FREQ, stats[2].median / ALT_CPU_FREQ, failed);
+
+					int hscd = stats[2].median < stats[1].median;
+					double accelerated = hscd ? stats[2].median : stats[1].median;
+					int known = crossoverWidth[xi][yi] != 0;
+					if (failed == 0 && accelerated < stats[0].median && (!known || width * height < crossoverWidth[xi][yi] * crossoverHeight[xi][yi]))
+					{
+						crossoverWidth[xi][yi]  = width;
+						crossoverHeight[xi][yi] = height;
+						crossoverHSCD[xi][yi]   = hscd;
+					}
+				}
+			}
+		}
+	}
+
+	fclose(f);
+	printf("Sweep written to %s\n", fname);
 
-	writeResults(testCases, seed);
+	for (int xi = 0; xi < 8; xi++)
+	{
+		for (int yi = 0; yi < 8; yi++)
+		{
+			if (crossoverWidth[xi][yi] == 0) { printf("Scale %d %d: SW is faster on every size\n", validScales[xi], validScales[yi]); }
+			else                             { printf("Scale %d %d: %s is faster from %d x %d\n", validScales[xi], validScales[yi], crossoverHSCD[xi][yi] ? "HSCD" : "HW", crossoverWidth[xi][yi], crossoverHeight[xi][yi]); }
+		}
+	}
 }
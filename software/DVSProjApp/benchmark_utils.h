@@ -2,9 +2,23 @@
 #define BENCHMARK_UTILS_H_
 
 #include "hw_impl.h"
+#include "image_alloc.h"
+
+// Prefix for accessing files through hostfs, moves from project dir to root dir
+#ifndef HOSTFS_ROOT
+#define HOSTFS_ROOT "/mnt/host/../../"
+#endif
 
 int verify(unsigned char* reference, unsigned char* target, int size);
 int writeImage(char* fname, unsigned char* destinationImage, int destinationWidth, int destinationHeight);
-void benchmark(HWContext* ctx, char* fname, unsigned char* source, int width, int height);
+// Runs every test case warmup times without recording, then repeats times, zero repeats use the defaults
+// Writes raw times to benchmark_<seed>.csv, their statistics to benchmark_<seed>_stats.csv
+// pixels per cycle, bandwidth and speedup over software to benchmark_<seed>_throughput.csv
+// and the time the driver spent in each phase to benchmark_<seed>_phases.csv
+void benchmark(HWContext* ctx, ImageArena* arena, char* fname, unsigned char* source, int stride, int width, int height, int warmup, int repeats);
+
+// Runs every scaling factor pair on synthesized images of sizes from 16 up to maxSize in both dimensions, zero repeats use the default
+// Writes median SW, HW and HSCD times of every size and factor pair to fname and prints the smallest size on which HW or HSCD wins, naming the one that won
+void sweep(HWContext* ctx, ImageArena* arena, char* fname, int maxSize, int repeats);
 
 #endif /* BENCHMARK_UTILS_H_ */
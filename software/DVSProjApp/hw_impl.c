@@ -1,9 +1,14 @@
 #include "hw_impl.h"
 
 #include <stdio.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <system.h>
+#include <sys/alt_cache.h>
+#include <sys/alt_irq.h>
 #include <altera_avalon_sgdma_regs.h>
+#include <altera_avalon_performance_counter.h>
 
 // Memory Map
 #define CR_ADDR 0
@@ -22,19 +27,98 @@
 // Line buffer size, defined in hardware
 #define BUFFER_SIZE 1024
 
+// Descriptors reserved for each chain slot
+// Maximum input image size per pass is BUFFER_SIZE * BUFFER_SIZE pixels, larger regions are split into tiles
+// Maximum output image size per pass is 4 * BUFFER_SIZE * 4 * BUFFER_SIZE pixels
+// With one descriptor for each line that is 5 * BUFFER_SIZE, + 2 stop descriptors
+// Which is close enough to (BUFFER_SIZE + 1) * 5
+#define CHAIN_LENGTH ((BUFFER_SIZE + 1) * 5)
+
+// Largest transfer of one descriptor, bytes_to_transfer is 16 bits wide, kept a multiple of 32 bytes so long transfers stay aligned
+#define MAX_DESC_LENGTH 0xFFE0
+
 // Macro to calculate index in row linearized matrix from coordinates
 #define PIXEL(x, y, width) ((x) + (y) * (width))
 
+// Descriptors can be placed in a memory of their own, so that their fetches and write backs do not take SDRAM cycles from pixel data
+// Define HW_DESC_SECTION to the linker section of that memory, for example -DHW_DESC_SECTION=\".onchip_mem\", otherwise they come from the heap
+// The pool takes CHAIN_LENGTH * HW_CHAIN_SLOTS * ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE bytes, about 320 KiB
+#ifdef HW_DESC_SECTION
+static alt_sgdma_descriptor descPool[CHAIN_LENGTH * HW_CHAIN_SLOTS] __attribute__((section(HW_DESC_SECTION), aligned(ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE)));
+#endif
+
+// Phase timing, sections are only counted while the application has the performance counter running
+#if HW_PERF_FIRST_SECTION > 0
+#if HW_PERF_FIRST_SECTION + HW_PERF_PHASES - 1 > PERF_CNT_HOW_MANY_SECTIONS
+#error "Performance counter has too few sections for driver phase timing"
+#endif
+#define PHASE_BEGIN(n) PERF_BEGIN(PERF_CNT_BASE, n)
+#define PHASE_END(n)   PERF_END(PERF_CNT_BASE, n)
+#else
+#define PHASE_BEGIN(n)
+#define PHASE_END(n)
+#endif
+
+// Preparation of an accelerator pass over one tile, buildHWPass or buildHSCDPass
+typedef int (*BuildFunction)(HWContext* ctx, HWPass* pass, unsigned char* source, unsigned char* destination, int sourceWidth, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int destinationStride, int xScale, int yScale);
+
+// Program the accelerator for the pass at the head of the ring and start both SGDMAs on its chain
+// Called with interrupts disabled or from the SGDMA callbacks, the accelerator must be idle
+static void startPass(HWContext* ctx)
+{
+	HWPass* pass = &(ctx->passes[ctx->passHead]);
+
+	PHASE_BEGIN(HW_PERF_START);
+
+	IOWR_32DIRECT(ACC_SCALE_BASE, CR_ADDR, pass->cr);
+	IOWR_32DIRECT(ACC_SCALE_BASE, WH_ADDR, pass->wh);
+
+	// Reset completion flags
+	ctx->txDone = 0;
+	ctx->rxDone = 0;
+	ctx->passRunning = 1;
+
+	// Start tx and rx SGDMA, tx descriptors start at the beginning of the chain and rx right after tx stop descriptor
+	alt_sgdma_descriptor* desc = pass->chain->desc;
+	if (alt_avalon_sgdma_do_async_transfer(ctx->txHandle, &(desc[0])))                          { ctx->status = 4; ctx->passRunning = 0; }
+	else if (alt_avalon_sgdma_do_async_transfer(ctx->rxHandle, &(desc[pass->chain->txCount + 1]))) { ctx->status = 5; ctx->passRunning = 0; }
+
+	PHASE_END(HW_PERF_START);
+}
+
+// Retire the running pass once both SGDMAs have finished it and start the next prepared pass right away
+// The next chain is already built, so the accelerator only waits for this interrupt instead of for the CPU
+static void passDone(HWContext* ctx)
+{
+	if (!ctx->passRunning || ctx->txDone == 0 || ctx->rxDone == 0) { return; }
+
+	// Stop tx and rx SGDMA
+	alt_avalon_sgdma_stop(ctx->txHandle);
+	alt_avalon_sgdma_stop(ctx->rxHandle);
+
+	HWPass* pass = &(ctx->passes[ctx->passHead]);
+	pass->chain->busy = 0;
+	pass->job->passesDone++;
+
+	ctx->passHead = (ctx->passHead + 1) % HW_CHAIN_SLOTS;
+	ctx->passCount--;
+	ctx->passRunning = 0;
+
+	if (ctx->passCount > 0 && ctx->status == 0) { startPass(ctx); }
+}
+
 // SGDMA Transmit Complete callback
 void txCallback(void* ctx)
 {
 	((HWContext*)ctx)->txDone++;
+	passDone((HWContext*)ctx);
 }
 
 // SGDMA Receive Complete callback
 void rxCallback(void* ctx)
 {
 	((HWContext*)ctx)->rxDone++;
+	passDone((HWContext*)ctx);
 }
 
 void printHWError(HWContext* ctx)
@@ -53,6 +137,7 @@ void printHWError(HWContext* ctx)
 void cleanupHW(HWContext* ctx)
 {
 	if (ctx->mallocPtr != NULL) { free(ctx->mallocPtr); }
+	ctx->mallocPtr = NULL;
 }
 
 int checkHW(HWContext* ctx)
@@ -69,6 +154,12 @@ int checkHW(HWContext* ctx)
 void initHW(HWContext* ctx)
 {
 	ctx->status = 0;
+	ctx->jobHead = 0;
+	ctx->jobPrepare = 0;
+	ctx->jobTail = 0;
+	ctx->passHead = 0;
+	ctx->passCount = 0;
+	ctx->passRunning = 0;
 
 	// Open tx and rx SGDMA
 	ctx->txHandle = alt_avalon_sgdma_open(SGDMA_M2S_NAME);
@@ -77,18 +168,30 @@ void initHW(HWContext* ctx)
 	ctx->rxHandle = alt_avalon_sgdma_open(SGDMA_S2M_NAME);
 	if (ctx->rxHandle == NULL) { ctx->status = 2; return; }
 
-	// Allocate descriptors for maximum possible image size
-	// Maximum input image size is BUFFER_SIZE * BUFFER_SIZE pixels
-	// Maximum output image size is 4 * BUFFER_SIZE * 4 * BUFFER_SIZE pixels
-	// With one descriptor for each line that is 5 * BBUFFER_SIZE, + 2 stop descriptors, + 1 descriptor for alignment
-	// Which is close enough to (BUFFER_SIZE + 1) * 5
-	ctx->mallocPtr = malloc(((BUFFER_SIZE + 1) * 5) * ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE);
+#ifdef HW_DESC_SECTION
+	// Descriptor pool is placed and aligned by the linker
+	ctx->mallocPtr = NULL;
+	ctx->descPtr = descPool;
+#else
+	// Allocate descriptors for every chain slot, + 1 descriptor for alignment
+	ctx->mallocPtr = malloc((CHAIN_LENGTH * HW_CHAIN_SLOTS + 1) * ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE);
 	if (ctx->mallocPtr == NULL) { ctx->status = 3; return; }
 
 	// Zero log2(ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE) lsbs to guarantee alignment
 	// If that address is outside the allocated memory, increment descPtr
-	ctx->descPtr = (alt_sgdma_descriptor*)((alt_u32)ctx->mallocPtr & ~(ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE - 1));
+	ctx->descPtr = (alt_sgdma_descriptor*)((uintptr_t)ctx->mallocPtr & ~(ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE - 1));
 	if (ctx->descPtr < ctx->mallocPtr) { ctx->descPtr++; }
+#endif
+
+	// Split descriptors between chain slots, all of them start out empty
+	ctx->chainClock = 0;
+	for (int i = 0; i < HW_CHAIN_SLOTS; i++)
+	{
+		ctx->chains[i].valid = 0;
+		ctx->chains[i].busy = 0;
+		ctx->chains[i].lastUse = 0;
+		ctx->chains[i].desc = &(ctx->descPtr[i * CHAIN_LENGTH]);
+	}
 
 	// Register tx and rx callbacks
 	alt_u32 controlMask = (ALTERA_AVALON_SGDMA_CONTROL_IE_GLOBAL_MSK | ALTERA_AVALON_SGDMA_CONTROL_IE_CHAIN_COMPLETED_MSK | ALTERA_AVALON_SGDMA_CONTROL_PARK_MSK);
@@ -96,13 +199,89 @@ void initHW(HWContext* ctx)
 	alt_avalon_sgdma_register_callback(ctx->rxHandle, rxCallback, controlMask, ctx);
 }
 
-void scaleHW(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+// Find the chain built for the same key and hand it back to hardware, or pick the least recently used slot to build a new one in
+// Controllers clear the ownership bit of every descriptor they complete, everything else in a finished chain is still valid
+// On a miss the key is recorded and the caller has to construct the chain and mark it valid
+// Chains of passes that are queued or running are skipped, NULL is returned when all of them are
+static HWChain* lookupChain(HWContext* ctx, int* hit, int hscd, unsigned char* source, unsigned char* destination, int sourceWidth, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int destinationStride, int xScale, int yScale)
+{
+	// Clear the whole key first so padding does not affect the comparison
+	HWChainKey key;
+	memset(&key, 0, sizeof(HWChainKey));
+	key.hscd              = hscd;
+	key.source            = source;
+	key.destination       = destination;
+	key.sourceWidth       = sourceWidth;
+	key.x                 = x;
+	key.y                 = y;
+	key.width             = width;
+	key.height            = height;
+	key.destinationWidth  = destinationWidth;
+	key.destinationHeight = destinationHeight;
+	key.destinationStride = destinationStride;
+	key.xScale            = xScale;
+	key.yScale            = yScale;
+
+	HWChain* chain = NULL;
+	*hit = 0;
+	for (int i = 0; i < HW_CHAIN_SLOTS; i++)
+	{
+		HWChain* slot = &(ctx->chains[i]);
+		if (slot->busy) { continue; }
+		if (slot->valid && memcmp(&key, &slot->key, sizeof(HWChainKey)) == 0) { chain = slot; *hit = 1; break; }
+		if (chain == NULL || slot->lastUse < chain->lastUse) { chain = slot; }
+	}
+	if (chain == NULL) { return NULL; }
+	chain->lastUse = ++ctx->chainClock;
+	chain->busy = 1;
+
+	if (!*hit)
+	{
+		chain->valid = 0;
+		chain->key = key;
+		return chain;
+	}
+
+	// Descriptors are read by the controllers from memory, so write around the data cache like the construct functions do
+	int count = chain->txCount + 1 + chain->rxCount;
+	volatile alt_sgdma_descriptor* desc = alt_remap_uncached(chain->desc, count * ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE);
+	for (int i = 0; i < chain->txCount; i++)         { desc[i].control = ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK; }
+	for (int i = chain->txCount + 1; i < count; i++) { desc[i].control = ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK; }
+	return chain;
+}
+
+// Construct descriptors for count lines of length bytes that start stride bytes apart and return the number of descriptors used
+// Lines that directly follow each other in memory form one run, which is covered by as few descriptors as the length field allows
+static int constructLines(alt_sgdma_descriptor* desc, int toMemory, unsigned char* base, int length, int stride, int count)
 {
 	int descIdx = 0;
+	int runs = stride == length ? 1 : count;
+	int runLength = stride == length ? length * count : length;
 
-	// Check image size
-	if (width  > BUFFER_SIZE) { ctx->status = 6; return; }
-	if (height > BUFFER_SIZE) { ctx->status = 7; return; }
+	for (int i = 0; i < runs; i++)
+	{
+		for (int offset = 0; offset < runLength; offset += MAX_DESC_LENGTH)
+		{
+			alt_u32* address = (alt_u32*)&base[i * stride + offset];
+			alt_u16 bytes = runLength - offset < MAX_DESC_LENGTH ? runLength - offset : MAX_DESC_LENGTH;
+			if (toMemory) { alt_avalon_sgdma_construct_stream_to_mem_desc(&(desc[descIdx]), &(desc[descIdx + 1]), address, bytes, 0); }
+			else          { alt_avalon_sgdma_construct_mem_to_stream_desc(&(desc[descIdx]), &(desc[descIdx + 1]), address, bytes, 0, 0, 0, 0); }
+			descIdx++;
+		}
+	}
+	return descIdx;
+}
+
+// Prepare one accelerator pass over a region that fits the line buffer, destination lines are destinationStride apart
+// Returns 0 when all chains are in use
+static int buildHWPass(HWContext* ctx, HWPass* pass, unsigned char* source, unsigned char* destination, int sourceWidth, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int destinationStride, int xScale, int yScale)
+{
+	int descIdx = 0;
+
+	// Look up the chain before the scaling factors get encoded
+	int cached;
+	HWChain* chain = lookupChain(ctx, &cached, 0, source, destination, sourceWidth, x, y, width, height, destinationWidth, destinationHeight, destinationStride, xScale, yScale);
+	if (chain == NULL) { return 0; }
 
 	// Encode scaling factor
 	int xUpscale = (xScale > 0);
@@ -110,57 +289,41 @@ void scaleHW(HWContext* ctx, unsigned char* source, unsigned char* destination,
 	xScale = xScale > 0 ? xScale - 1 : -xScale - 1;
 	yScale = yScale > 0 ? yScale - 1 : -yScale - 1;
 
-	// Write memory-mapped registers
-	alt_u32 cr = yUpscale << Y_UPSCALE_OFFSET | yScale << Y_SCALE_OFFSET | xUpscale << X_UPSCALE_OFFSET | xScale << X_SCALE_OFFSET;
-	alt_u32 wh = height << HEIGHT_OFFSET | width << WIDTH_OFFSET;
-	IOWR_32DIRECT(ACC_SCALE_BASE, CR_ADDR, cr);
-	IOWR_32DIRECT(ACC_SCALE_BASE, WH_ADDR, wh);
-
-	// Start using descriptors for tx from the beginning
-	alt_sgdma_descriptor* txDesc = &(ctx->descPtr[descIdx]);
-	for (int i = 0; i < height; i++)
-	{
-		// Construct descriptor for each source line
-		alt_avalon_sgdma_construct_mem_to_stream_desc(&(ctx->descPtr[descIdx]), &(ctx->descPtr[descIdx + 1]), (alt_u32*)&source[PIXEL(x, y + i, sourceWidth)], width, 0, 0, 0, 0);
-		descIdx++;
-	}
-	// Set next descriptor as stop descriptor
-	ctx->descPtr[descIdx++].control = 0;
+	// Values for memory-mapped registers, written when the pass starts
+	pass->cr = yUpscale << Y_UPSCALE_OFFSET | yScale << Y_SCALE_OFFSET | xUpscale << X_UPSCALE_OFFSET | xScale << X_SCALE_OFFSET;
+	pass->wh = height << HEIGHT_OFFSET | width << WIDTH_OFFSET;
+	pass->chain = chain;
 
-	// Start using descriptors for rx right after tx stop descriptor
-	alt_sgdma_descriptor* rxDesc = &(ctx->descPtr[descIdx]);
-	for (int i = 0; i < destinationHeight; i++)
+	// Descriptors only depend on addresses and geometry, rebuild them when those change
+	alt_sgdma_descriptor* desc = chain->desc;
+	if (!cached)
 	{
-		// Construct descriptor for each destination line
-		alt_avalon_sgdma_construct_stream_to_mem_desc(&(ctx->descPtr[descIdx]), &(ctx->descPtr[descIdx + 1]), (alt_u32*)&destination[PIXEL(0, i, destinationWidth)], destinationWidth, 0);
-		descIdx++;
+		// Start using descriptors for tx from the beginning, one for each source line unless lines are contiguous
+		descIdx += constructLines(&(desc[descIdx]), 0, &source[PIXEL(x, y, sourceWidth)], width, sourceWidth, height);
+		chain->txCount = descIdx;
+		// Set next descriptor as stop descriptor
+		desc[descIdx++].control = 0;
+
+		// Start using descriptors for rx right after tx stop descriptor, one for each destination line unless lines are contiguous
+		descIdx += constructLines(&(desc[descIdx]), 1, destination, destinationWidth, destinationStride, destinationHeight);
+		chain->rxCount = descIdx - chain->txCount - 1;
+		// Set next descriptor as stop descriptor
+		desc[descIdx++].control = 0;
+		chain->valid = 1;
 	}
-	// Set next descriptor as stop descriptor
-	ctx->descPtr[descIdx++].control = 0;
-
-	// Reset completion flags
-	ctx->txDone = 0;
-	ctx->rxDone = 0;
-
-	// Start tx and rx SGDMA
-	if (alt_avalon_sgdma_do_async_transfer(ctx->txHandle, txDesc)) { ctx->status = 4; return; }
-	if (alt_avalon_sgdma_do_async_transfer(ctx->rxHandle, rxDesc)) { ctx->status = 5; return; }
-
-	// Wait for completion
-	while (ctx->txDone == 0 || ctx->rxDone == 0) {}
-
-	// Stop tx and rx SGDMA
-	alt_avalon_sgdma_stop(ctx->txHandle);
-	alt_avalon_sgdma_stop(ctx->rxHandle);
+	return 1;
 }
 
-void scaleHSCD(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+// Prepare one HSCD pass over a region that fits the line buffer, destination lines are destinationStride apart
+// Returns 0 when all chains are in use
+static int buildHSCDPass(HWContext* ctx, HWPass* pass, unsigned char* source, unsigned char* destination, int sourceWidth, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int destinationStride, int xScale, int yScale)
 {
 	int descIdx = 0;
 
-	// Check image size
-	if (width  > BUFFER_SIZE) { ctx->status = 6; return; }
-	if (height > BUFFER_SIZE) { ctx->status = 7; return; }
+	// Look up the chain before the scaling factors get encoded
+	int cached;
+	HWChain* chain = lookupChain(ctx, &cached, 1, source, destination, sourceWidth, x, y, width, height, destinationWidth, destinationHeight, destinationStride, xScale, yScale);
+	if (chain == NULL) { return 0; }
 
 	// Encode scaling factor
 	int xUpscale = (xScale > 0);
@@ -168,61 +331,255 @@ void scaleHSCD(HWContext* ctx, unsigned char* source, unsigned char* destination
 	xScale = xScale > 0 ? xScale - 1 : -xScale - 1;
 	yScale = yScale > 0 ? yScale - 1 : -yScale - 1;
 
-	// Start using descriptors for tx from the beginning
-	alt_sgdma_descriptor* txDesc = &(ctx->descPtr[descIdx]);
-	if (yUpscale)
+	// Descriptors only depend on addresses and geometry, rebuild them when those change
+	alt_sgdma_descriptor* desc = chain->desc;
+	if (!cached)
 	{
-		for (int i = 0; i < height; i++)
-		{
-			// If upscaling construct descriptors as usual
-			alt_avalon_sgdma_construct_mem_to_stream_desc(&(ctx->descPtr[descIdx]), &(ctx->descPtr[descIdx + 1]), (alt_u32*)&source[PIXEL(x, y + i, sourceWidth)], width, 0, 0, 0, 0);
-			descIdx++;
-		}
+		// Start using descriptors for tx from the beginning, if upscaling construct descriptors as usual
+		// If downscaling construct descriptors only for each yScale-th source line, which are never contiguous
+		if (yUpscale) { descIdx += constructLines(&(desc[descIdx]), 0, &source[PIXEL(x, y, sourceWidth)], width, sourceWidth, height); }
+		else          { descIdx += constructLines(&(desc[descIdx]), 0, &source[PIXEL(x, y, sourceWidth)], width, sourceWidth * (yScale + 1), destinationHeight); }
+		chain->txCount = descIdx;
+		// Set next descriptor as stop descriptor
+		desc[descIdx++].control = 0;
+
+		// Start using descriptors for rx right after tx stop descriptor, rx descriptors are same as usual
+		descIdx += constructLines(&(desc[descIdx]), 1, destination, destinationWidth, destinationStride, destinationHeight);
+		chain->rxCount = descIdx - chain->txCount - 1;
+		// Set next descriptor as stop descriptor
+		desc[descIdx++].control = 0;
+		chain->valid = 1;
 	}
-	else
+	// When downscaling extra lines are not transmitted, so yScale is 1 (encoded as 0) and height is the same as destinationHeight
+	if (!yUpscale)
 	{
-		for (int i = 0; i < height; i+= yScale + 1)
-		{
-			// If downscaling construct descriptors only for each yScale-th source line
-			alt_avalon_sgdma_construct_mem_to_stream_desc(&(ctx->descPtr[descIdx]), &(ctx->descPtr[descIdx + 1]), (alt_u32*)&source[PIXEL(x, y + i, sourceWidth)], width, 0, 0, 0, 0);
-			descIdx++;
-		}
-		// Since extra lines are not transmitted yScale is 1 (encoded as 0) and height is the same as destinationHeight
 		yScale = 0;
 		height = destinationHeight;
 	}
-	// Set next descriptor as stop descriptor
-	ctx->descPtr[descIdx++].control = 0;
 
-	// Start using descriptors for rx right after tx stop descriptor
-	alt_sgdma_descriptor* rxDesc = &(ctx->descPtr[descIdx]);
-	for (int i = 0; i < destinationHeight; i++)
-	{
-		// Rx descriptors are same as usual
-		alt_avalon_sgdma_construct_stream_to_mem_desc(&(ctx->descPtr[descIdx]), &(ctx->descPtr[descIdx + 1]), (alt_u32*)&destination[PIXEL(0, i, destinationWidth)], destinationWidth, 0);
-		descIdx++;
-	}
-	// Set next descriptor as stop descriptor
-	ctx->descPtr[descIdx++].control = 0;
+	// Values for memory-mapped registers, computed here since yScale and height change when downscaling
+	pass->cr = yUpscale << Y_UPSCALE_OFFSET | yScale << Y_SCALE_OFFSET | xUpscale << X_UPSCALE_OFFSET | xScale << X_SCALE_OFFSET;
+	pass->wh = height << HEIGHT_OFFSET | width << WIDTH_OFFSET;
+	pass->chain = chain;
+	return 1;
+}
 
-	// Write memory-mapped registers here since yScale and height may change after descriptor construction
-	alt_u32 cr = yUpscale << Y_UPSCALE_OFFSET | yScale << Y_SCALE_OFFSET | xUpscale << X_UPSCALE_OFFSET | xScale << X_SCALE_OFFSET;
-	alt_u32 wh = height << HEIGHT_OFFSET | width << WIDTH_OFFSET;
-	IOWR_32DIRECT(ACC_SCALE_BASE, CR_ADDR, cr);
-	IOWR_32DIRECT(ACC_SCALE_BASE, WH_ADDR, wh);
+// Largest tile extent along one axis
+// When downscaling a tile must hold whole groups of scale pixels, so that every tile samples the same pixels a single pass would
+static int tileSize(int scale)
+{
+	return scale > 0 ? BUFFER_SIZE : BUFFER_SIZE - BUFFER_SIZE % -scale;
+}
 
-	// Reset completion flags
-	ctx->txDone = 0;
-	ctx->rxDone = 0;
+// Destination extent of a source extent
+static int scaledSize(int size, int scale)
+{
+	return scale > 0 ? size * scale : (size - scale - 1) / -scale;
+}
 
-	// Start tx and rx SGDMA
-	if (alt_avalon_sgdma_do_async_transfer(ctx->txHandle, txDesc)) { ctx->status = 4; return; }
-	if (alt_avalon_sgdma_do_async_transfer(ctx->rxHandle, rxDesc)) { ctx->status = 5; return; }
+// Prepare the pass over the next tile of the job and move on to the tile after it, returns 0 when all chains are in use
+// Tiles are taken row by row and write into their place in the destination image, so no stitching is needed afterwards
+static int prepareNextTile(HWContext* ctx, HWJob* job, HWPass* pass)
+{
+	int tileWidth  = tileSize(job->xScale);
+	int tileHeight = tileSize(job->yScale);
+	int w = job->width  - job->tileX < tileWidth  ? job->width  - job->tileX : tileWidth;
+	int h = job->height - job->tileY < tileHeight ? job->height - job->tileY : tileHeight;
+
+	unsigned char* tileDestination = &(job->destination[PIXEL(scaledSize(job->tileX, job->xScale), scaledSize(job->tileY, job->yScale), job->destinationStride)]);
+	BuildFunction build = job->hscd ? buildHSCDPass : buildHWPass;
+	if (!build(ctx, pass, job->source, tileDestination, job->sourceWidth, job->x + job->tileX, job->y + job->tileY, w, h, scaledSize(w, job->xScale), scaledSize(h, job->yScale), job->destinationStride, job->xScale, job->yScale)) { return 0; }
+	pass->job = job;
+
+	job->tileX += tileWidth;
+	if (job->tileX >= job->width) { job->tileX = 0; job->tileY += tileHeight; }
+	return 1;
+}
 
-	// Wait for completion
-	while (ctx->txDone == 0 || ctx->rxDone == 0) {}
+static int jobDone(HWContext* ctx, HWJob* job)
+{
+	return job == NULL || job->passesDone == job->passes || ctx->status != 0;
+}
 
-	// Stop tx and rx SGDMA
+// After an error nothing else runs, stop whatever the SGDMAs still have in flight and retire all passes and jobs
+// A pass fails to start with tx already started when rx can not be, that one would otherwise stall on a full stream forever
+// Chains of dropped passes may be partly run, so they are built again the next time they are needed
+static void abortQueue(HWContext* ctx)
+{
+	alt_irq_context irq = alt_irq_disable_all();
 	alt_avalon_sgdma_stop(ctx->txHandle);
 	alt_avalon_sgdma_stop(ctx->rxHandle);
+	for (int i = 0; i < HW_CHAIN_SLOTS; i++)
+	{
+		if (ctx->chains[i].busy) { ctx->chains[i].busy = 0; ctx->chains[i].valid = 0; }
+	}
+	ctx->passHead = 0;
+	ctx->passCount = 0;
+	ctx->passRunning = 0;
+	ctx->txDone = 0;
+	ctx->rxDone = 0;
+	alt_irq_enable_all(irq);
+
+	ctx->jobHead = ctx->jobPrepare = ctx->jobTail;
+}
+
+// Keep the pass ring full with passes of queued jobs and retire finished jobs
+// The next pass is built while the current one runs, so callbacks can start it as soon as the accelerator is free
+static void pumpQueue(HWContext* ctx)
+{
+	while (ctx->status == 0 && ctx->jobPrepare != ctx->jobTail && ctx->passCount < HW_CHAIN_SLOTS)
+	{
+		HWJob* job = &(ctx->jobs[ctx->jobPrepare % HW_QUEUE_LENGTH]);
+		HWPass pass;
+		PHASE_BEGIN(HW_PERF_PREPARE);
+		int prepared = prepareNextTile(ctx, job, &pass);
+		PHASE_END(HW_PERF_PREPARE);
+		if (!prepared) { break; }
+		if (job->tileY >= job->height) { ctx->jobPrepare++; }
+
+		// Callbacks advance the ring as well, so keep them out while adding the pass and starting an idle accelerator
+		alt_irq_context irq = alt_irq_disable_all();
+		ctx->passes[(ctx->passHead + ctx->passCount) % HW_CHAIN_SLOTS] = pass;
+		ctx->passCount++;
+		if (!ctx->passRunning) { startPass(ctx); }
+		alt_irq_enable_all(irq);
+	}
+
+	while (ctx->jobHead != ctx->jobPrepare && jobDone(ctx, &(ctx->jobs[ctx->jobHead % HW_QUEUE_LENGTH]))) { ctx->jobHead++; }
+
+	if (ctx->status != 0) { abortQueue(ctx); }
+}
+
+#if NIOS2_DCACHE_SIZE > 0
+
+// Write back source lines of a region so the tx SGDMA reads what the CPU wrote, only lines of the region are touched
+// Past the size of the cache a whole cache flush is cheaper than going through every line of the region
+static void flushRegion(unsigned char* base, int width, int height, int stride)
+{
+	if ((alt_u32)width * height >= NIOS2_DCACHE_SIZE) { alt_dcache_flush_all(); return; }
+	for (int i = 0; i < height; i++) { alt_dcache_flush(&base[PIXEL(0, i, stride)], width); }
+}
+
+// Drop cached destination lines of a region so they are neither written back over nor read instead of rx SGDMA data
+// Lines at the ends of each row may also hold bytes outside the region, those are written back instead of dropped
+static void invalidateRegion(unsigned char* base, int width, int height, int stride)
+{
+	if ((alt_u32)width * height >= NIOS2_DCACHE_SIZE) { alt_dcache_flush_all(); return; }
+	for (int i = 0; i < height; i++)
+	{
+		uintptr_t start = (uintptr_t)&base[PIXEL(0, i, stride)];
+		uintptr_t end   = start + width;
+		uintptr_t first = (start + NIOS2_DCACHE_LINE_SIZE - 1) & ~(uintptr_t)(NIOS2_DCACHE_LINE_SIZE - 1);
+		uintptr_t last  = end & ~(uintptr_t)(NIOS2_DCACHE_LINE_SIZE - 1);
+
+		if (first >= last) { alt_dcache_flush((void*)start, width); continue; }
+		if (start != first) { alt_dcache_flush((void*)start, first - start); }
+		alt_dcache_flush_no_writeback((void*)first, last - first);
+		if (end != last) { alt_dcache_flush((void*)last, end - last); }
+	}
+}
+
+#endif
+
+// Queue a new job, waiting for the oldest one if the queue is full
+// Empty regions are rejected with NULL before anything is queued, so jobs already in the queue are not affected
+static HWJob* submitJob(HWContext* ctx, int hscd, unsigned char* source, unsigned char* destination, int sourceWidth, int x, int y, int width, int height, int destinationStride, int xScale, int yScale)
+{
+	if (width <= 0 || height <= 0) { return NULL; }
+
+	// Poll can report the oldest job done before it is retired, so retire it before reusing its slot
+	pumpQueue(ctx);
+	while (ctx->jobTail - ctx->jobHead >= HW_QUEUE_LENGTH)
+	{
+		scaleHWWait(ctx, &(ctx->jobs[ctx->jobHead % HW_QUEUE_LENGTH]));
+		pumpQueue(ctx);
+	}
+
+	HWJob* job = &(ctx->jobs[ctx->jobTail % HW_QUEUE_LENGTH]);
+	job->hscd              = hscd;
+	job->source            = source;
+	job->destination       = destination;
+	job->sourceWidth       = sourceWidth;
+	job->x                 = x;
+	job->y                 = y;
+	job->width             = width;
+	job->height            = height;
+	job->destinationStride = destinationStride;
+	job->xScale            = xScale;
+	job->yScale            = yScale;
+	job->tileX             = 0;
+	job->tileY             = 0;
+	job->passes            = 0;
+	job->passesDone        = 0;
+
+	// After an error jobs are reported as done through the status
+	if (ctx->status != 0) { return job; }
+
+	job->passes = ((width + tileSize(xScale) - 1) / tileSize(xScale)) * ((height + tileSize(yScale) - 1) / tileSize(yScale));
+
+#if NIOS2_DCACHE_SIZE > 0
+	// Callers do not have to maintain the cache around jobs
+	PHASE_BEGIN(HW_PERF_PREPARE);
+	flushRegion(&source[PIXEL(x, y, sourceWidth)], width, height, sourceWidth);
+	invalidateRegion(destination, scaledSize(width, xScale), scaledSize(height, yScale), destinationStride);
+	PHASE_END(HW_PERF_PREPARE);
+#endif
+
+	ctx->jobTail++;
+	pumpQueue(ctx);
+	return job;
+}
+
+HWJob* scaleHWSubmit(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	return submitJob(ctx, 0, source, destination, sourceWidth, x, y, width, height, destinationWidth, xScale, yScale);
+}
+
+HWJob* scaleHSCDSubmit(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	return submitJob(ctx, 1, source, destination, sourceWidth, x, y, width, height, destinationWidth, xScale, yScale);
+}
+
+int scaleHWPoll(HWContext* ctx, HWJob* job)
+{
+	pumpQueue(ctx);
+	return jobDone(ctx, job);
+}
+
+void scaleHWWait(HWContext* ctx, HWJob* job)
+{
+	PHASE_BEGIN(HW_PERF_WAIT);
+	while (!scaleHWPoll(ctx, job)) {}
+	PHASE_END(HW_PERF_WAIT);
+}
+
+// Blocking variants report an empty region through the status once the jobs queued before it are finished
+static void waitJob(HWContext* ctx, HWJob* job, int width, int height)
+{
+	if (job != NULL) { scaleHWWait(ctx, job); return; }
+
+	if (ctx->jobTail != ctx->jobHead) { scaleHWWait(ctx, &(ctx->jobs[(ctx->jobTail - 1) % HW_QUEUE_LENGTH])); }
+	if (ctx->status != 0) { return; }
+	if (width  <= 0) { ctx->status = 6; return; }
+	if (height <= 0) { ctx->status = 7; return; }
+}
+
+void scaleHW(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	waitJob(ctx, submitJob(ctx, 0, source, destination, sourceWidth, x, y, width, height, destinationWidth, xScale, yScale), width, height);
+}
+
+void scaleHSCD(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	waitJob(ctx, submitJob(ctx, 1, source, destination, sourceWidth, x, y, width, height, destinationWidth, xScale, yScale), width, height);
+}
+
+void scaleHWInto(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationX, int destinationY, int destinationStride, int xScale, int yScale)
+{
+	waitJob(ctx, submitJob(ctx, 0, source, &destination[PIXEL(destinationX, destinationY, destinationStride)], sourceWidth, x, y, width, height, destinationStride, xScale, yScale), width, height);
+}
+
+void scaleHSCDInto(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationX, int destinationY, int destinationStride, int xScale, int yScale)
+{
+	waitJob(ctx, submitJob(ctx, 1, source, &destination[PIXEL(destinationX, destinationY, destinationStride)], sourceWidth, x, y, width, height, destinationStride, xScale, yScale), width, height);
 }
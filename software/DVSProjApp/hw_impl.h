@@ -3,6 +3,87 @@
 
 #include <altera_avalon_sgdma.h>
 
+// Number of descriptor chains kept for reuse, one each for scaleHW and scaleHSCD running on the same image
+// Also the length of the pass ring, the next pass is built in one chain while the other one runs
+#define HW_CHAIN_SLOTS 2
+
+// Number of jobs that can be submitted before submitting waits for the oldest one
+#define HW_QUEUE_LENGTH 4
+
+// Performance counter sections the driver times its phases in, the application keeps the sections before them
+// Preparing passes (cache maintenance, register values and descriptors), programming the accelerator and starting the SGDMAs,
+// and waiting for jobs including the SGDMA stop in the callbacks
+// Passes started from the callbacks are counted both as started and as waited for, as are passes prepared while waiting
+// Define HW_PERF_FIRST_SECTION to 0 to build the driver without timing
+#ifndef HW_PERF_FIRST_SECTION
+#define HW_PERF_FIRST_SECTION 5
+#endif
+#define HW_PERF_PREPARE (HW_PERF_FIRST_SECTION + 0)
+#define HW_PERF_START   (HW_PERF_FIRST_SECTION + 1)
+#define HW_PERF_WAIT    (HW_PERF_FIRST_SECTION + 2)
+#define HW_PERF_PHASES  3
+
+// Everything the descriptors of one pass depend on, a pass with the same key can rerun the previous chain
+typedef struct
+{
+	int hscd;
+	unsigned char* source;
+	unsigned char* destination;
+	int sourceWidth;
+	int x;
+	int y;
+	int width;
+	int height;
+	int destinationWidth;
+	int destinationHeight;
+	int destinationStride;
+	int xScale;
+	int yScale;
+} HWChainKey;
+
+// Descriptor chain of one pass, tx descriptors start at desc and rx descriptors right after the tx stop descriptor
+typedef struct
+{
+	int valid;
+	int busy;
+	int txCount;
+	int rxCount;
+	alt_u32 lastUse;
+	HWChainKey key;
+	alt_sgdma_descriptor* desc;
+} HWChain;
+
+// Accelerator job, regions larger than the line buffer are run as several passes, one tile at a time
+typedef struct
+{
+	int hscd;
+	unsigned char* source;
+	unsigned char* destination;
+	int sourceWidth;
+	int x;
+	int y;
+	int width;
+	int height;
+	int destinationStride;
+	int xScale;
+	int yScale;
+	// Top left corner of the next tile, relative to the region
+	int tileX;
+	int tileY;
+	// Number of passes the job is split into and how many of them finished
+	int passes;
+	volatile int passesDone;
+} HWJob;
+
+// Pass prepared for the accelerator, register values and the chain to run
+typedef struct
+{
+	HWJob* job;
+	HWChain* chain;
+	alt_u32 cr;
+	alt_u32 wh;
+} HWPass;
+
 typedef struct
 {
 	int status;
@@ -12,6 +93,19 @@ typedef struct
 	alt_sgdma_descriptor* descPtr;
 	volatile alt_32 txDone;
 	volatile alt_32 rxDone;
+	alt_u32 chainClock;
+	HWChain chains[HW_CHAIN_SLOTS];
+	// Job queue, counters only grow and index jobs modulo HW_QUEUE_LENGTH
+	// Jobs from jobHead to jobPrepare have all passes prepared, from jobPrepare to jobTail wait for free chains
+	HWJob jobs[HW_QUEUE_LENGTH];
+	int jobHead;
+	int jobPrepare;
+	int jobTail;
+	// Ring of prepared passes, the one at passHead runs when passRunning is set
+	HWPass passes[HW_CHAIN_SLOTS];
+	volatile int passHead;
+	volatile int passCount;
+	volatile int passRunning;
 } HWContext;
 
 void printHWError(HWContext* ctx);
@@ -21,4 +115,20 @@ void initHW(HWContext* ctx);
 void scaleHW(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
 void scaleHSCD(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
 
+// Same as scaleHW and scaleHSCD, but write the scaled region at (destinationX, destinationY) of a larger image with lines destinationStride bytes apart
+// Pixels of the destination image outside the scaled region are left untouched
+void scaleHWInto(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationX, int destinationY, int destinationStride, int xScale, int yScale);
+void scaleHSCDInto(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationX, int destinationY, int destinationStride, int xScale, int yScale);
+
+// Non-blocking variants of scaleHW and scaleHSCD, submit queues the job and returns its handle
+// Poll returns 1 once the job is done, either finished or failed with ctx->status set, and Wait blocks until then
+// Submitting an empty region returns NULL without queueing anything, Poll and Wait report NULL as done
+// Up to HW_QUEUE_LENGTH jobs can be queued, submitting to a full queue waits for the oldest job first
+// Handles stay valid until HW_QUEUE_LENGTH more jobs are submitted
+// Passes are started back to back from the SGDMA callbacks, Poll and Wait prepare the chains of the following passes
+HWJob* scaleHWSubmit(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+HWJob* scaleHSCDSubmit(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+int scaleHWPoll(HWContext* ctx, HWJob* job);
+void scaleHWWait(HWContext* ctx, HWJob* job);
+
 #endif /* HW_IMPL_H_ */
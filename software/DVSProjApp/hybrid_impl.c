@@ -0,0 +1,95 @@
+#include "hybrid_impl.h"
+
+#include <system.h>
+
+#include "sw_impl.h"
+#include "hw_impl.h"
+
+// Macro to calculate index in row linearized matrix from coordinates
+#define PIXEL(x, y, width) ((x) + (y) * (width))
+
+// Macro to calculate index into tables of scale factors
+#define SCALE_IDX(scale) ((scale) < 0 ? (scale) + 4 : (scale) + 3)
+
+// Latest measurement for one pair of scale factors, all zero until recorded
+typedef struct
+{
+	alt_u64 swTicks;
+	alt_u64 hwTicks;
+	alt_u64 hscdTicks;
+} HybridRates;
+
+static HybridRates rates[8][8];
+
+void hybridRecord(int xScale, int yScale, alt_u64 swTicks, alt_u64 hwTicks, alt_u64 hscdTicks)
+{
+	HybridRates* r = &rates[SCALE_IDX(xScale)][SCALE_IDX(yScale)];
+	r->swTicks   = swTicks;
+	r->hwTicks   = hwTicks;
+	r->hscdTicks = hscdTicks;
+}
+
+// Scale line groups [first, first + count) of the region on the CPU
+// A group is one source line and its yScale copies when upscaling, or one destination line and its -yScale source lines when downscaling
+static void scaleGroupsSW(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale, int first, int count)
+{
+	int sourceRows      = yScale > 0 ? 1 : -yScale;
+	int destinationRows = yScale > 0 ? yScale : 1;
+
+	int sourceFirst      = first * sourceRows;
+	int sourceLines      = count * sourceRows;
+	int destinationFirst = first * destinationRows;
+	int destinationLines = count * destinationRows;
+	if (sourceFirst + sourceLines > height)                     { sourceLines = height - sourceFirst; }
+	if (destinationFirst + destinationLines > destinationHeight) { destinationLines = destinationHeight - destinationFirst; }
+
+	scaleSW(source, &destination[PIXEL(0, destinationFirst, destinationWidth)], sourceWidth, sourceHeight, x, y + sourceFirst, width, sourceLines, destinationWidth, destinationLines, xScale, yScale);
+}
+
+void scaleHybrid(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	HybridRates* r = &rates[SCALE_IDX(xScale)][SCALE_IDX(yScale)];
+	int hscd = r->hscdTicks < r->hwTicks;
+	alt_u64 hwTicks = hscd ? r->hscdTicks : r->hwTicks;
+
+	// Both sides should finish at the same time, so the accelerator gets swTicks / (swTicks + hwTicks) of the groups
+	int groups = yScale > 0 ? height : destinationHeight;
+	int hwGroups = groups;
+	if (r->swTicks != 0 && hwTicks != 0) { hwGroups = (int)((alt_u64)groups * r->swTicks / (r->swTicks + hwTicks)); }
+
+	int sourceRows      = yScale > 0 ? 1 : -yScale;
+	int destinationRows = yScale > 0 ? yScale : 1;
+
+	// Not worth splitting
+	if (hwGroups == 0)
+	{
+		scaleSW(source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale);
+		return;
+	}
+	if (hwGroups == groups)
+	{
+		if (hscd) { scaleHSCD(ctx, source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+		else      { scaleHW(ctx, source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+		return;
+	}
+
+	// Start the accelerator on the top groups and scale the rest on the CPU in the meantime
+	int hwHeight = hwGroups * sourceRows;
+	int hwDestinationHeight = hwGroups * destinationRows;
+	HWJob* job;
+	if (hscd) { job = scaleHSCDSubmit(ctx, source, destination, sourceWidth, sourceHeight, x, y, width, hwHeight, destinationWidth, hwDestinationHeight, xScale, yScale); }
+	else      { job = scaleHWSubmit(ctx, source, destination, sourceWidth, sourceHeight, x, y, width, hwHeight, destinationWidth, hwDestinationHeight, xScale, yScale); }
+
+	scaleGroupsSW(source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale, hwGroups, groups - hwGroups);
+
+	scaleHWWait(ctx, job);
+
+#if NIOS2_DCACHE_SIZE > 0
+	// The cache line holding the first CPU written byte may also hold the last accelerator written bytes
+	// Writing it allocated the line before the accelerator was done, so rewrite those groups now that memory is up to date
+	int lineRows = (NIOS2_DCACHE_LINE_SIZE + destinationWidth - 1) / destinationWidth;
+	int lineGroups = (lineRows + destinationRows - 1) / destinationRows;
+	if (lineGroups > hwGroups) { lineGroups = hwGroups; }
+	scaleGroupsSW(source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale, hwGroups - lineGroups, lineGroups);
+#endif
+}
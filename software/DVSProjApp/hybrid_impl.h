@@ -0,0 +1,18 @@
+#ifndef HYBRID_IMPL_H_
+#define HYBRID_IMPL_H_
+
+#include <alt_types.h>
+
+#include "hw_impl.h"
+
+// Record measured times of scaleSW, scaleHW and scaleHSCD on the same region for a pair of scale factors
+// Times are in performance counter ticks, the latest measurement for a pair replaces the previous one
+void hybridRecord(int xScale, int yScale, alt_u64 swTicks, alt_u64 hwTicks, alt_u64 hscdTicks);
+
+// Same as scaleHW, but splits the region by rows between the accelerator and scaleSW running at the same time
+// Top rows go to the faster of scaleHW and scaleHSCD, the rest to the CPU, in proportion to the recorded throughputs
+// Without a recorded measurement for the pair the whole region goes to the accelerator
+// On the host build SW times are native while HW times come from the bus model, so the split leans heavily towards the CPU there
+void scaleHybrid(HWContext* ctx, unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+
+#endif /* HYBRID_IMPL_H_ */
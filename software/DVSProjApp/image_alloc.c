@@ -0,0 +1,72 @@
+#include "image_alloc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <system.h>
+#include <sys/alt_cache.h>
+
+int imageStride(int width)
+{
+	return (width + IMAGE_ALIGN - 1) & ~(IMAGE_ALIGN - 1);
+}
+
+// The block returned by malloc is kept in the word before the aligned buffer, like descriptors in initHW the buffer is aligned by hand
+// Nothing of the buffer may be left in the cache once it is accessed through the uncached alias
+// Flushing includes the word before the buffer, imageFree reads it through the alias
+static unsigned char* makeUncached(unsigned char* image, int size)
+{
+#if NIOS2_DCACHE_SIZE > 0
+	alt_dcache_flush(image - sizeof(void*), size + sizeof(void*));
+	image = (unsigned char*)alt_remap_uncached(image, size);
+#endif
+	return image;
+}
+
+unsigned char* imageAlloc(int size, int uncached)
+{
+	unsigned char* block = malloc(size + IMAGE_ALIGN + sizeof(void*));
+	if (block == NULL) { return NULL; }
+
+	unsigned char* image = (unsigned char*)(((uintptr_t)block + sizeof(void*) + IMAGE_ALIGN - 1) & ~(uintptr_t)(IMAGE_ALIGN - 1));
+	((void**)image)[-1] = block;
+
+	return uncached ? makeUncached(image, size) : image;
+}
+
+void imageFree(unsigned char* image)
+{
+	if (image == NULL) { return; }
+
+	// The word before the buffer reads the same through either alias
+	free(((void**)image)[-1]);
+}
+
+int arenaInit(ImageArena* arena, int size)
+{
+	arena->size = size;
+	arena->used = 0;
+	arena->base = imageAlloc(size, 0);
+	return arena->base == NULL;
+}
+
+void arenaCleanup(ImageArena* arena)
+{
+	imageFree(arena->base);
+	arena->base = NULL;
+}
+
+unsigned char* arenaAlloc(ImageArena* arena, int size, int uncached)
+{
+	// Every buffer starts IMAGE_ALIGN aligned, the base is aligned as well
+	int offset = (arena->used + IMAGE_ALIGN - 1) & ~(IMAGE_ALIGN - 1);
+	if (arena->base == NULL || size < 0 || size > arena->size - offset) { return NULL; }
+	arena->used = offset + size;
+
+	// Memory was handed out before, possibly cached, so an uncached buffer still needs its lines flushed
+	return uncached ? makeUncached(&arena->base[offset], size) : &arena->base[offset];
+}
+
+void arenaReset(ImageArena* arena)
+{
+	arena->used = 0;
+}
@@ -0,0 +1,34 @@
+#ifndef IMAGE_ALLOC_H_
+#define IMAGE_ALLOC_H_
+
+// Alignment of image buffers and of padded lines, covers a data cache line and a full SGDMA burst
+#define IMAGE_ALIGN 32
+
+// Line stride of an image of the given width, padded so that every line starts aligned
+// Widths that are not a multiple of IMAGE_ALIGN get a gap after every line, so full width regions of such images no longer
+// have their source lines coalesced into shared tx descriptors and take one descriptor per line instead
+// Aligned lines keep the word kernels of scaleSW and whole SGDMA bursts on every line, which is worth more than the descriptors
+int imageStride(int width);
+
+// Allocate an IMAGE_ALIGN aligned image buffer, NULL on failure
+// Uncached buffers bypass the data cache, for buffers the CPU rarely touches so the driver has no lines to maintain for them
+unsigned char* imageAlloc(int size, int uncached);
+void imageFree(unsigned char* image);
+
+// Fixed region carved from the heap once, buffers are handed out by bumping an offset and all released at once by a reset
+// Serves every buffer of one command or benchmark without calling malloc and free, so the heap can not fragment over time
+typedef struct
+{
+	unsigned char* base;
+	int size;
+	int used;
+} ImageArena;
+
+// Returns 0 on success, 1 when the region can not be allocated
+int arenaInit(ImageArena* arena, int size);
+void arenaCleanup(ImageArena* arena);
+// Same as imageAlloc but from the arena, NULL when the arena is full
+unsigned char* arenaAlloc(ImageArena* arena, int size, int uncached);
+void arenaReset(ImageArena* arena);
+
+#endif /* IMAGE_ALLOC_H_ */
@@ -7,9 +7,21 @@
 
 #include "sw_impl.h"
 #include "hw_impl.h"
+#include "hybrid_impl.h"
+#include "auto_impl.h"
+#include "image_alloc.h"
 #include "benchmark_utils.h"
 
 #define MAX_PATH 256
+#define COST_MODEL "cost_model.txt"
+#define SWEEP_MAX_SIZE 1024
+
+// SDRAM budget, the program keeps IMAGE_PROGRAM_RESERVE of SDRAM_SPAN and the image arena gets the rest, 56 MiB of 64 MiB
+// The reserve holds code and data (well under 1 MiB), the stack and the heap outside the arena, mostly the driver descriptors (about 320 KiB)
+// The arena holds the buffers of one command or benchmark, a 1024 x 1024 image needs about 33 MiB for a benchmark and 49 MiB for a 4 x 4 resize
+// Commands that need more than the arena fail to allocate their buffers and report it
+#define IMAGE_PROGRAM_RESERVE (8 * 1024 * 1024)
+#define IMAGE_ARENA_SIZE (SDRAM_SPAN - IMAGE_PROGRAM_RESERVE)
 #define CCC(cmd) if (checkCommand(cmd)) { continue; }
 
 typedef struct
@@ -17,6 +29,12 @@ typedef struct
 	int status;
 	char fname[MAX_PATH];
 	int benchmark;
+	int warmup;
+	int repeats;
+	int sweep;
+	int sweepSize;
+	int model;
+	int combined;
 	int xScale;
 	int yScale;
 	int x;
@@ -27,6 +45,7 @@ typedef struct
 	int h;
 	int sourceWidth;
 	int sourceHeight;
+	int sourceStride;
 	int destinationWidth;
 	int destinationHeight;
 	int sourceSize;
@@ -34,12 +53,19 @@ typedef struct
 	unsigned char* sourceImage;
 	unsigned char* referenceImage;
 	unsigned char* destinationImage;
+	unsigned char* checkImage;
 } Command;
 
+// Source, reference and destination buffers are all taken from the arena and released together after each command
+static ImageArena arena;
+
 void printHelp()
 {
-	printf("Enter command in this format <filename> (B | [R <x> <y> <w> <h>] <scale factor>)\n");
-	printf("B starts benchmark, no other parameters are allowed\n");
+	printf("Enter command in this format <filename> (B [<repeats> [<warmup>]] | S [<max size> [<repeats>]] | M | [C] [R <x> <y> <w> <h>] <scale factor>)\n");
+	printf("B starts benchmark, optionally with the number of measured and unmeasured warmup runs of each test case\n");
+	printf("S sweeps all scale factors over synthesized images of sizes from 16 up to max size, at most %d, and writes the table to the file\n", SWEEP_MAX_SIZE);
+	printf("M loads the cost model for automatic scaler selection from the file, no other parameters are allowed\n");
+	printf("C also runs the hybrid scaler and the scaler automatic selection picks and verifies them, the saved image is the HSCD result\n");
 	printf("R selects the part of the picture to scale\n");
 	printf("Scale factor is one or two numbers in range {-4, -3, -2, -1, 1, 2, 3, 4}\n");
 	printf("If two numbers are specified they are x and y scaling factors respectively\n");
@@ -57,14 +83,19 @@ void printError(Command* cmd)
 	else if (status == 10 || status == 11) { printf("Failed to allocate output buffers\n"); }
 	else if (status >= 12 && status <= 15) { printf("Failed to save image\n"); }
 	else if (status == 16)                 { printf("Hardware error\n"); }
+	else if (status == 17)                 { printf("End of input\n"); }
+	else if (status == 18)                 { printf("Failed to load cost model\n"); }
+	else if (status == 19)                 { printf("Invalid benchmark parameters\n"); }
 	else                                   { printf("Unknown error\n"); }
 }
 
 void cleanup(Command* cmd)
 {
-	if (cmd->sourceImage      != NULL) { free(cmd->sourceImage);      cmd->sourceImage      = NULL; }
-	if (cmd->referenceImage   != NULL) { free(cmd->referenceImage);   cmd->referenceImage   = NULL; }
-	if (cmd->destinationImage != NULL) { free(cmd->destinationImage); cmd->destinationImage = NULL; }
+	cmd->sourceImage      = NULL;
+	cmd->referenceImage   = NULL;
+	cmd->destinationImage = NULL;
+	cmd->checkImage       = NULL;
+	arenaReset(&arena);
 }
 
 int checkCommand(Command* cmd)
@@ -78,6 +109,35 @@ int checkCommand(Command* cmd)
 	return 0;
 }
 
+// Read an optional number, returns 1 when it was read, 0 at the end of line and -1 when the input is not a number
+int parseNumber(int* value)
+{
+	char next;
+
+	// Eat up all spaces, end of line leaves the value unchanged
+	for (next = ' '; next == ' '; next = getchar()) {}
+	if (next == '\n' || next == '\r') { return 0; }
+	ungetc(next, stdin);
+
+	return scanf("%d", value) == 1 ? 1 : -1;
+}
+
+void parseBenchmark(Command* cmd)
+{
+	int read = parseNumber(&cmd->repeats);
+	if (read == 1 && cmd->repeats < 1) { read = -1; }
+	if (read == 1) { read = parseNumber(&cmd->warmup); }
+	if (read < 0 || cmd->warmup < 0) { cmd->status = 19; }
+}
+
+void parseSweep(Command* cmd)
+{
+	int read = parseNumber(&cmd->sweepSize);
+	if (read == 1 && (cmd->sweepSize < 16 || cmd->sweepSize > SWEEP_MAX_SIZE)) { read = -1; }
+	if (read == 1) { read = parseNumber(&cmd->repeats); }
+	if (read < 0 || cmd->repeats < 0 || (read == 1 && cmd->repeats == 0)) { cmd->status = 19; }
+}
+
 Command parseCommand()
 {
 	char next;
@@ -85,6 +145,12 @@ Command parseCommand()
 
 	cmd.status            = 0;
 	cmd.benchmark         = 0;
+	cmd.warmup            = 0;
+	cmd.repeats           = 0;
+	cmd.sweep             = 0;
+	cmd.sweepSize         = SWEEP_MAX_SIZE;
+	cmd.model             = 0;
+	cmd.combined          = 0;
 	cmd.xScale            = 0;
 	cmd.yScale            = 0;
 	cmd.x                 = -1;
@@ -95,20 +161,29 @@ Command parseCommand()
 	cmd.h                 = -1;
 	cmd.sourceWidth       = -1;
 	cmd.sourceHeight      = -1;
+	cmd.sourceStride      = -1;
 	cmd.destinationWidth  = -1;
 	cmd.destinationHeight = -1;
 	cmd.sourceImage       = NULL;
 	cmd.referenceImage    = NULL;
 	cmd.destinationImage  = NULL;
+	cmd.checkImage        = NULL;
 
-	// Read filename
-	scanf("%s", cmd.fname);
+	// Read filename, input can only end when not running on JTAG UART
+	if (scanf("%s", cmd.fname) != 1) { cmd.status = 17; return cmd; }
 
 	// Eat up all spaces
 	for (next = ' '; next == ' '; next = getchar()) {}
 
-	// If next character is B we are in benchmark mode, return
-	if (next == 'B') { cmd.benchmark = 1; return cmd; }
+	// If next character is C the combined scalers run as well, eat up spaces and continue with the region and scale factors
+	if (next == 'C') { cmd.combined = 1; for (next = getchar(); next == ' '; next = getchar()) {} }
+
+	// If next character is B we are in benchmark mode, read optional repeat and warmup counts and return
+	if (next == 'B') { cmd.benchmark = 1; parseBenchmark(&cmd); return cmd; }
+	// If next character is S the file receives the sweep table, read optional size limit and repeat count and return
+	else if (next == 'S') { cmd.sweep = 1; parseSweep(&cmd); return cmd; }
+	// If next character is M the file is a cost model to load, return
+	else if (next == 'M') { cmd.model = 1; return cmd; }
 	// If next character is R read which part of image to resize
 	else if (next == 'R') { scanf("%d %d %d %d", &cmd.x, &cmd.y, &cmd.w, &cmd.h); }
 	// Else return character to buffer and proceed with reading scale factors
@@ -135,7 +210,7 @@ Command parseCommand()
 void loadImage(Command* cmd)
 {
 	// Prepared path to access hostfs and move to root dir
-	char ffname[MAX_PATH] = "/mnt/host/../../";
+	char ffname[MAX_PATH] = HOSTFS_ROOT;
 	// Append entered filename
 	strcat(ffname, cmd->fname);
 
@@ -150,18 +225,32 @@ void loadImage(Command* cmd)
 	read = fread(&cmd->sourceHeight, sizeof(int), 1, f);
 	if (read != 1) { fclose(f); cmd->status = 3; return; }
 
-	// Calculate image size and allocate memory
-	cmd->sourceSize = cmd->sourceWidth * cmd->sourceHeight;
-	cmd->sourceImage = malloc(sizeof(unsigned char) * cmd->sourceSize);
+	// Calculate image size and allocate memory, lines are padded so that each one starts aligned for the SGDMA
+	cmd->sourceStride = imageStride(cmd->sourceWidth);
+	cmd->sourceSize = cmd->sourceStride * cmd->sourceHeight;
+	cmd->sourceImage = arenaAlloc(&arena, sizeof(unsigned char) * cmd->sourceSize, 0);
 	if (cmd->sourceImage == NULL) { fclose(f); cmd->status = 4; return; }
 
-	// Read image data into allocated buffer
-	read = fread(cmd->sourceImage, sizeof(unsigned char), cmd->sourceSize, f);
-	if (read != cmd->sourceSize) { fclose(f); cmd->status = 5; return; }
+	// Read image data into allocated buffer line by line
+	for (int i = 0; i < cmd->sourceHeight; i++)
+	{
+		read = fread(&cmd->sourceImage[i * cmd->sourceStride], sizeof(unsigned char), cmd->sourceWidth, f);
+		if (read != cmd->sourceWidth) { fclose(f); cmd->status = 5; return; }
+	}
 
 	fclose(f);
 }
 
+void loadModel(Command* cmd)
+{
+	// Prepared path to access hostfs and move to root dir
+	char ffname[MAX_PATH] = HOSTFS_ROOT;
+	// Append entered filename
+	strcat(ffname, cmd->fname);
+
+	if (loadCostModel(ffname)) { cmd->status = 18; }
+}
+
 void prepareCommand(Command* cmd)
 {
 	int validScales[] = {-4, -3, -2, -1, 1, 2, 3, 4};
@@ -198,11 +287,18 @@ void prepareCommand(Command* cmd)
 	cmd->destinationSize = cmd->destinationWidth * cmd->destinationHeight;
 
 	// Allocate two buffers for destination image, one for software and one for hardware scaling
-	cmd->referenceImage   = malloc(sizeof(unsigned char) * cmd->destinationSize);
-	cmd->destinationImage = malloc(sizeof(unsigned char) * cmd->destinationSize);
+	// The CPU only verifies and saves the hardware result, so that buffer bypasses the cache
+	cmd->referenceImage   = arenaAlloc(&arena, sizeof(unsigned char) * cmd->destinationSize, 0);
+	cmd->destinationImage = arenaAlloc(&arena, sizeof(unsigned char) * cmd->destinationSize, 1);
 
 	if (cmd->referenceImage   == NULL) { cmd->status = 10; return; }
 	if (cmd->destinationImage == NULL) { cmd->status = 11; return; }
+
+	// The combined scalers are only verified, they get a third buffer
+	// The hybrid scaler writes part of its result from the CPU, so that buffer is cached like the software one
+	if (cmd->combined == 0) { return; }
+	cmd->checkImage = arenaAlloc(&arena, sizeof(unsigned char) * cmd->destinationSize, 0);
+	if (cmd->checkImage == NULL) { cmd->status = 11; return; }
 }
 
 void resizeImage(Command* cmd, HWContext* ctx)
@@ -214,44 +310,102 @@ void resizeImage(Command* cmd, HWContext* ctx)
 	PERF_RESET(PERF_CNT_BASE);
 	PERF_START_MEASURING(PERF_CNT_BASE);
 
-	// Flush cache and start measuring time
+	// Flush cache so the software scaler starts cold and start measuring time
 	alt_dcache_flush_all();
 	PERF_BEGIN(PERF_CNT_BASE, 1);
 
 	// Run software scaler
-	scaleSW(cmd->sourceImage, cmd->referenceImage, cmd->sourceWidth, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
+	scaleSW(cmd->sourceImage, cmd->referenceImage, cmd->sourceStride, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
 
 	PERF_END(PERF_CNT_BASE, 1);
 
-	// Flush cache and start measuring time
-	alt_dcache_flush_all();
+	// Start measuring time, the driver maintains the cache for the lines it transfers
 	PERF_BEGIN(PERF_CNT_BASE, 2);
 
 	// Run hardware scaler
-	scaleHW(ctx, cmd->sourceImage, cmd->destinationImage, cmd->sourceWidth, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
+	scaleHW(ctx, cmd->sourceImage, cmd->destinationImage, cmd->sourceStride, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
 
 	PERF_END(PERF_CNT_BASE, 2);
 
-	// Verify result
-	if (checkHW(ctx)) { cmd->status = 16; return; }
+	// Verify result, a failed context is set up again so later commands can still use the accelerator
+	if (checkHW(ctx)) { initHW(ctx); cmd->status = 16; return; }
 	resHW = verify(cmd->referenceImage, cmd->destinationImage, cmd->destinationSize);
 
-	// Flush cache and start measuring time
-	alt_dcache_flush_all();
+	// Start measuring time, the driver maintains the cache for the lines it transfers
 	PERF_BEGIN(PERF_CNT_BASE, 3);
 
 	// Run hardware/software scaler
-	scaleHSCD(ctx, cmd->sourceImage, cmd->destinationImage, cmd->sourceWidth, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
+	scaleHSCD(ctx, cmd->sourceImage, cmd->destinationImage, cmd->sourceStride, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
 
 	PERF_END(PERF_CNT_BASE, 3);
 
 	// Verify result
-	if (checkHW(ctx)) { cmd->status = 16; return; }
+	if (checkHW(ctx)) { initHW(ctx); cmd->status = 16; return; }
 	resHSCD = verify(cmd->referenceImage, cmd->destinationImage, cmd->destinationSize);
 
 	// Print results
 	printf("HW scaling: %s, HSCD scaling: %s\n", resHW == 0 ? "OK" : "ERR", resHSCD == 0 ? "OK" : "ERR");
 	perf_print_formatted_report(PERF_CNT_BASE, ALT_CPU_CPU_FREQ, 3, "SW", "HW", "HSCD");
+
+#if HW_PERF_FIRST_SECTION > 0
+	// Driver phases of the HW and HSCD runs together
+	printf("Driver phases: prepare %f s, start %f s, wait %f s\n",
+		(double)perf_get_section_time(PERF_CNT_BASE, HW_PERF_PREPARE) / ALT_CPU_FREQ,
+		(double)perf_get_section_time(PERF_CNT_BASE, HW_PERF_START)   / ALT_CPU_FREQ,
+		(double)perf_get_section_time(PERF_CNT_BASE, HW_PERF_WAIT)    / ALT_CPU_FREQ);
+#endif
+}
+
+// Runs after resizeImage, which leaves the SW, HW and HSCD times of the command in their sections
+void combineImage(Command* cmd, HWContext* ctx)
+{
+	int resHybrid;
+
+	// Split the hybrid run according to the times just measured, then time it on a restarted counter
+	hybridRecord(cmd->xScale, cmd->yScale, perf_get_section_time(PERF_CNT_BASE, 1), perf_get_section_time(PERF_CNT_BASE, 2), perf_get_section_time(PERF_CNT_BASE, 3));
+
+	PERF_RESET(PERF_CNT_BASE);
+	PERF_START_MEASURING(PERF_CNT_BASE);
+
+	// Start measuring time, the driver maintains the cache for the lines it transfers
+	PERF_BEGIN(PERF_CNT_BASE, 4);
+
+	// Run hardware and software scalers together, into a buffer of its own so that the saved image stays the HSCD result
+	scaleHybrid(ctx, cmd->sourceImage, cmd->checkImage, cmd->sourceStride, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
+
+	PERF_END(PERF_CNT_BASE, 4);
+
+	// Verify result
+	if (checkHW(ctx)) { initHW(ctx); cmd->status = 16; return; }
+	resHybrid = verify(cmd->referenceImage, cmd->checkImage, cmd->destinationSize);
+
+	printf("Hybrid scaling: %s, %f s\n", resHybrid == 0 ? "OK" : "ERR", (double)perf_get_section_time(PERF_CNT_BASE, 4) / ALT_CPU_FREQ);
+}
+
+// Runs after combineImage, times the scaler scaleAuto picks for the command on a restarted counter
+void autoImage(Command* cmd, HWContext* ctx)
+{
+	int resAuto;
+
+	char* names[AUTO_PATHS] = {"SW", "HW", "HSCD"};
+	int misaligned = costMisaligned(cmd->sourceImage, cmd->sourceStride, cmd->x, cmd->y, cmd->checkImage, cmd->destinationWidth);
+	int path = chooseScaler(misaligned, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
+
+	PERF_RESET(PERF_CNT_BASE);
+	PERF_START_MEASURING(PERF_CNT_BASE);
+	PERF_BEGIN(PERF_CNT_BASE, 1);
+
+	scaleAuto(ctx, cmd->sourceImage, cmd->checkImage, cmd->sourceStride, cmd->sourceHeight, cmd->x, cmd->y, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale);
+
+	PERF_END(PERF_CNT_BASE, 1);
+
+	// Verify result
+	if (checkHW(ctx)) { initHW(ctx); cmd->status = 16; return; }
+	resAuto = verify(cmd->referenceImage, cmd->checkImage, cmd->destinationSize);
+
+	printf("Auto scaling picks %s: %s, %f s, predicted %f s\n", names[path], resAuto == 0 ? "OK" : "ERR",
+		(double)perf_get_section_time(PERF_CNT_BASE, 1) / ALT_CPU_FREQ,
+		predictCost(path, misaligned, cmd->w, cmd->h, cmd->destinationWidth, cmd->destinationHeight, cmd->xScale, cmd->yScale));
 }
 
 void saveImage(Command* cmd)
@@ -274,11 +428,34 @@ int main()
 	initHW(ctx);
 	if (checkHW(ctx)) { return 0; }
 
+	// Carve image memory once, commands only bump allocate from it
+	if (arenaInit(&arena, IMAGE_ARENA_SIZE)) { printf("Failed to allocate image memory\n"); cleanupHW(ctx); return 0; }
+
+	// Cost model fitted from earlier benchmark results is optional, scaleAuto falls back to HSCD without it
+	if (loadCostModel(HOSTFS_ROOT COST_MODEL) == 0) { printf("Cost model loaded\n"); }
+
 	printHelp();
 
 	while(1)
 	{
 		command = parseCommand();
+		if (cmd->status == 17) { break; }
+		CCC(cmd);
+
+		if (cmd->model)
+		{
+			loadModel(cmd);
+			CCC(cmd);
+			printf("Cost model loaded\n");
+			continue;
+		}
+
+		if (cmd->sweep)
+		{
+			sweep(ctx, &arena, cmd->fname, cmd->sweepSize, cmd->repeats);
+			cleanup(cmd);
+			continue;
+		}
 
 		loadImage(cmd);
 		CCC(cmd);
@@ -286,7 +463,7 @@ int main()
 
 		if (cmd->benchmark)
 		{
-			benchmark(ctx, cmd->fname, cmd->sourceImage, cmd->sourceWidth, cmd->sourceHeight);
+			benchmark(ctx, &arena, cmd->fname, cmd->sourceImage, cmd->sourceStride, cmd->sourceWidth, cmd->sourceHeight, cmd->warmup, cmd->repeats);
 		}
 		else
 		{
@@ -297,6 +474,15 @@ int main()
 			CCC(cmd);
 			printf("Image resized\n");
 
+			if (cmd->combined)
+			{
+				combineImage(cmd, ctx);
+				CCC(cmd);
+
+				autoImage(cmd, ctx);
+				CCC(cmd);
+			}
+
 			saveImage(cmd);
 			CCC(cmd);
 			printf("Image saved\n");
@@ -305,6 +491,7 @@ int main()
 		cleanup(cmd);
 	}
 
+	arenaCleanup(&arena);
 	cleanupHW(ctx);
 
 	return 0;
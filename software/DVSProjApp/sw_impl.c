@@ -1,11 +1,61 @@
 #include "sw_impl.h"
+#include "sw_simd.h"
 
+#include <stdint.h>
 #include <string.h>
 
 // Macro to calculate index in row linearized matrix from coordinates
 #define PIXEL(x, y, width) ((x) + (y) * (width))
 
-void scaleLineSW(unsigned char* source, unsigned char* destination, int width, int xScale)
+// Word parallel line scaling relies on little endian byte order inside words, as on Nios II
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define SW_WORD_PARALLEL 1
+#else
+#define SW_WORD_PARALLEL 0
+#endif
+
+// Word type allowed to alias image bytes
+typedef uint32_t __attribute__((__may_alias__)) Word;
+
+// Replicate a byte into all four bytes of a word
+#define SPLAT(b) ((b) * 0x01010101u)
+// Extract n-th byte of a word
+#define BYTE(w, n) (((w) >> (8 * (n))) & 0xFF)
+
+// Streams source words from an arbitrarily aligned address using only aligned loads
+// Every loaded word contains at least one byte that is requested, so loads never leave the source buffer's pages
+typedef struct
+{
+	const Word* ptr;
+	Word current;
+	int shift;
+} WordReader;
+
+static inline void readerInit(WordReader* reader, const unsigned char* source)
+{
+	uintptr_t address = (uintptr_t)source;
+	reader->shift = (address & 3) * 8;
+	reader->ptr = (const Word*)(address & ~(uintptr_t)3);
+	reader->current = *reader->ptr;
+}
+
+static inline Word readerNext(WordReader* reader)
+{
+	if (reader->shift == 0) { return *reader->ptr++; }
+
+	// Funnel shift two aligned words into the unaligned one
+	Word next = reader->ptr[1];
+	Word word = (reader->current >> reader->shift) | (next << (32 - reader->shift));
+	reader->ptr++;
+	reader->current = next;
+	return word;
+}
+
+// Force inlining so that callers passing a constant scale get code specialized for it
+#define SW_INLINE static inline __attribute__((always_inline))
+
+// Byte at a time line scaling, handles any alignment and length
+SW_INLINE void scaleLineBytes(unsigned char* source, unsigned char* destination, int width, int xScale)
 {
 	if (xScale > 0)
 	{
@@ -40,34 +90,231 @@ void scaleLineSW(unsigned char* source, unsigned char* destination, int width, i
 	}
 }
 
-void scaleSW(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+// Upscale four source pixels at a time into xScale aligned destination words
+SW_INLINE void upscaleLineWords(unsigned char* source, unsigned char* destination, int width, int xScale)
 {
-		if (yScale > 0)
+	int i = 0;
+
+	// Prologue, write single pixels until destination is word aligned
+	// Each pixel advances destination by xScale bytes, so for even scales alignment may never be reached
+	for (; i < width && i < 3 && ((uintptr_t)destination & 3); i++, destination += xScale)
 	{
-				// For each source line, scale it and write it to destination yScale times
-		for (int i = 0, j = 0; i < height; i++, j += yScale)
+		scaleLineBytes(&source[i], destination, 1, xScale);
+	}
+
+	if (((uintptr_t)destination & 3) == 0 && i + 4 <= width)
+	{
+		WordReader reader;
+		readerInit(&reader, &source[i]);
+		Word* out = (Word*)destination;
+
+		for (; i + 4 <= width; i += 4)
 		{
-			// We scale the first line manually and memcpy it remaining yScale - 1 times via fall-through switch statement similar to those used when loop unrolling, again in hopes of compiler optimization
-			scaleLineSW(&source[PIXEL(x, y + i, sourceWidth)], &destination[PIXEL(0, j, destinationWidth)], width, xScale);
-			switch (yScale)
+			Word w = readerNext(&reader);
+			switch (xScale)
+			{
+			case 2:
 			{
-			case 4: { memcpy(&destination[PIXEL(0, j + 3, destinationWidth)], &destination[PIXEL(0, j, destinationWidth)], destinationWidth); }
-			case 3: { memcpy(&destination[PIXEL(0, j + 2, destinationWidth)], &destination[PIXEL(0, j, destinationWidth)], destinationWidth); }
-			case 2: { memcpy(&destination[PIXEL(0, j + 1, destinationWidth)], &destination[PIXEL(0, j, destinationWidth)], destinationWidth); }
-			default: { break; }
+				// Spread pixel pairs to every other byte and fill the gaps
+				Word lo = BYTE(w, 0) | (BYTE(w, 1) << 16);
+				Word hi = BYTE(w, 2) | (BYTE(w, 3) << 16);
+				out[0] = lo | (lo << 8);
+				out[1] = hi | (hi << 8);
+				out += 2;
+				break;
+			}
+			case 3:
+			{
+				out[0] = (SPLAT(BYTE(w, 0)) & 0x00FFFFFF) | (BYTE(w, 1) << 24);
+				out[1] = (SPLAT(BYTE(w, 1)) & 0x0000FFFF) | (SPLAT(BYTE(w, 2)) & 0xFFFF0000);
+				out[2] = BYTE(w, 2) | (SPLAT(BYTE(w, 3)) & 0xFFFFFF00);
+				out += 3;
+				break;
+			}
+			default:
+			{
+				out[0] = SPLAT(BYTE(w, 0));
+				out[1] = SPLAT(BYTE(w, 1));
+				out[2] = SPLAT(BYTE(w, 2));
+				out[3] = SPLAT(BYTE(w, 3));
+				out += 4;
+				break;
+			}
 			}
 		}
+
+		destination = (unsigned char*)out;
 	}
-	else
+
+	// Epilogue, remaining pixels or whole line if destination could not be aligned
+	scaleLineBytes(&source[i], destination, width - i, xScale);
+}
+
+// Downscale by gathering every xScale-th source byte into packed destination words
+SW_INLINE void downscaleLineWords(unsigned char* source, unsigned char* destination, int width, int xScale)
+{
+	int i = 0;
+
+	// Prologue, write single pixels until destination is word aligned
+	for (; i < width && ((uintptr_t)destination & 3); i += xScale, destination++)
 	{
-		// When downscaling we have to negate the scaling factor
-		yScale = - yScale;
+		*destination = source[i];
+	}
 
-				// For each yScale-th source line, scale it and write it to destination in consecutive locations
-		for (int i = 0, j = 0; i < height; i += yScale, j++)
+	// Four destination pixels need 4 * xScale source pixels, which is exactly xScale source words
+	if (i + 4 * xScale <= width)
+	{
+		WordReader reader;
+		readerInit(&reader, &source[i]);
+		Word* out = (Word*)destination;
+
+		for (; i + 4 * xScale <= width; i += 4 * xScale)
 		{
-			scaleLineSW(&source[PIXEL(x, y + i, sourceWidth)], &destination[PIXEL(0, j, destinationWidth)], width, xScale);
+			Word w0 = readerNext(&reader);
+			Word w1 = readerNext(&reader);
+			switch (xScale)
+			{
+			case 2:
+			{
+				*out++ = BYTE(w0, 0) | (BYTE(w0, 2) << 8) | (BYTE(w1, 0) << 16) | (BYTE(w1, 2) << 24);
+				break;
+			}
+			case 3:
+			{
+				Word w2 = readerNext(&reader);
+				*out++ = BYTE(w0, 0) | (BYTE(w0, 3) << 8) | (BYTE(w1, 2) << 16) | (BYTE(w2, 1) << 24);
+				break;
+			}
+			default:
+			{
+				Word w2 = readerNext(&reader);
+				Word w3 = readerNext(&reader);
+				*out++ = BYTE(w0, 0) | (BYTE(w1, 0) << 8) | (BYTE(w2, 0) << 16) | (BYTE(w3, 0) << 24);
+				break;
+			}
+			}
 		}
+
+		destination = (unsigned char*)out;
+	}
+
+	// Epilogue, remaining pixels
+	scaleLineBytes(&source[i], destination, width - i, -xScale);
+}
+
+// Scale a line with the given kernel prefix and finish with word or byte code, inlined with constant xScale
+SW_INLINE void scaleLineWith(unsigned char* source, unsigned char* destination, int width, int xScale, SIMDLineKernel simd)
+{
+	// Scale of one in either direction is a plain copy
+	if (xScale == 1 || xScale == -1)
+	{
+		memcpy(destination, source, width);
+		return;
+	}
+
+	// Vector kernels take whole blocks from the start of the line, the rest is finished below
+	if (simd != NULL)
+	{
+		int done = simd(source, destination, width);
+		source += done;
+		destination += xScale > 0 ? done * xScale : done / -xScale;
+		width -= done;
+	}
+
+	if (!SW_WORD_PARALLEL)
+	{
+		scaleLineBytes(source, destination, width, xScale);
+	}
+	else if (xScale > 0)
+	{
+		upscaleLineWords(source, destination, width, xScale);
+	}
+	else
+	{
+		// When downscaling we have to negate the scaling factor
+		downscaleLineWords(source, destination, width, -xScale);
 	}
 }
 
+// Line and frame kernels specialized for every scale factor, selected once per call through tables below
+typedef void (*LineKernel)(unsigned char* source, unsigned char* destination, int width, SIMDLineKernel simd);
+typedef void (*FrameKernel)(unsigned char* source, unsigned char* destination, int sourceWidth, int width, int height, int destinationWidth);
+
+// Invoke macro M for every scale factor, with a name suffix, the factor and extra arguments
+// Separate copies for x and y are needed since a macro can not expand itself
+#define SW_FOR_EACH_X(M, ...) M(N4, -4, __VA_ARGS__) M(N3, -3, __VA_ARGS__) M(N2, -2, __VA_ARGS__) M(N1, -1, __VA_ARGS__) \
+                              M(P1,  1, __VA_ARGS__) M(P2,  2, __VA_ARGS__) M(P3,  3, __VA_ARGS__) M(P4,  4, __VA_ARGS__)
+#define SW_FOR_EACH_Y(M, ...) M(N4, -4, __VA_ARGS__) M(N3, -3, __VA_ARGS__) M(N2, -2, __VA_ARGS__) M(N1, -1, __VA_ARGS__) \
+                              M(P1,  1, __VA_ARGS__) M(P2,  2, __VA_ARGS__) M(P3,  3, __VA_ARGS__) M(P4,  4, __VA_ARGS__)
+
+// Macro to map scale factors {-4, -3, -2, -1, 1, 2, 3, 4} to kernel table index
+#define SCALE_IDX(scale) ((scale) < 0 ? (scale) + 4 : (scale) + 3)
+
+#define SW_LINE_KERNEL(xName, xScale, unused) \
+static void scaleLine##xName(unsigned char* source, unsigned char* destination, int width, SIMDLineKernel simd) \
+{ \
+	scaleLineWith(source, destination, width, xScale, simd); \
+}
+
+SW_FOR_EACH_X(SW_LINE_KERNEL, 0)
+
+static const LineKernel lineKernels[8] = {
+#define SW_LINE_ENTRY(xName, xScale, unused) scaleLine##xName,
+	SW_FOR_EACH_X(SW_LINE_ENTRY, 0)
+#undef SW_LINE_ENTRY
+};
+
+// Frame kernel for one pair of factors, constant yScale turns the line replication and skipping into fixed steps
+// Line kernel and vector prefix are looked up once, so the loop over lines does no factor checks
+#define SW_FRAME_KERNEL(yName, yScale, xName, xScale) \
+static void scaleFrame##xName##yName(unsigned char* source, unsigned char* destination, int sourceWidth, int width, int height, int destinationWidth) \
+{ \
+	SIMDLineKernel simd = simdLineKernel(xScale); \
+	if (yScale > 0) \
+	{ \
+		/* For each source line, scale it once and copy it to the remaining yScale - 1 destination lines */ \
+		for (int i = 0, j = 0; i < height; i++, j += yScale) \
+		{ \
+			unsigned char* line = &destination[PIXEL(0, j, destinationWidth)]; \
+			scaleLine##xName(&source[PIXEL(0, i, sourceWidth)], line, width, simd); \
+			for (int r = 1; r < yScale; r++) { memcpy(&line[PIXEL(0, r, destinationWidth)], line, destinationWidth); } \
+		} \
+	} \
+	else \
+	{ \
+		/* For each -yScale-th source line, scale it and write it to destination in consecutive locations */ \
+		for (int i = 0, j = 0; i < height; i -= yScale, j++) \
+		{ \
+			scaleLine##xName(&source[PIXEL(0, i, sourceWidth)], &destination[PIXEL(0, j, destinationWidth)], width, simd); \
+		} \
+	} \
+}
+#define SW_FRAME_KERNELS(xName, xScale, unused) SW_FOR_EACH_Y(SW_FRAME_KERNEL, xName, xScale)
+
+SW_FOR_EACH_X(SW_FRAME_KERNELS, 0)
+
+// Indexed by SCALE_IDX(xScale) and then SCALE_IDX(yScale)
+static const FrameKernel frameKernels[8][8] = {
+#define SW_FRAME_ENTRY(yName, yScale, xName) scaleFrame##xName##yName,
+#define SW_FRAME_ROW(xName, xScale, unused) { SW_FOR_EACH_Y(SW_FRAME_ENTRY, xName) },
+	SW_FOR_EACH_X(SW_FRAME_ROW, 0)
+#undef SW_FRAME_ROW
+#undef SW_FRAME_ENTRY
+};
+
+void scaleLineReference(unsigned char* source, unsigned char* destination, int width, int xScale)
+{
+	if (xScale == 1 || xScale == -1) { memcpy(destination, source, width); return; }
+	scaleLineBytes(source, destination, width, xScale);
+}
+
+void scaleLineSW(unsigned char* source, unsigned char* destination, int width, int xScale)
+{
+	lineKernels[SCALE_IDX(xScale)](source, destination, width, simdLineKernel(xScale));
+}
+
+void scaleSW(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	// Pick the kernel specialized for this pair of factors, it starts at the top left corner of the region
+	frameKernels[SCALE_IDX(xScale)][SCALE_IDX(yScale)](&source[PIXEL(x, y, sourceWidth)], destination, sourceWidth, width, height, destinationWidth);
+}
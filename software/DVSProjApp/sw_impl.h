@@ -3,4 +3,13 @@
 
 void scaleSW(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
 
+// Same as scaleSW, but splits the destination into bands of lines processed by a thread pool where threads are available
+void scaleSWParallel(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale);
+
+// Scale one line with the fastest kernel for the factor, vector prefix and word parallel code included
+void scaleLineSW(unsigned char* source, unsigned char* destination, int width, int xScale);
+
+// Scale one line a byte at a time, what scaleLineSW does without vector and word parallel code, for checking the faster kernels
+void scaleLineReference(unsigned char* source, unsigned char* destination, int width, int xScale);
+
 #endif /* SW_IMPL_H_ */
@@ -0,0 +1,171 @@
+#include "sw_impl.h"
+
+// Thread pool is only available on hosts with POSIX threads, SW_THREADS is set by the host build
+#ifndef SW_THREADS
+#define SW_THREADS 0
+#endif
+
+#if SW_THREADS
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Macro to calculate index in row linearized matrix from coordinates
+#define PIXEL(x, y, width) ((x) + (y) * (width))
+
+// Bands per thread, more bands than threads balance uneven progress
+#define BANDS_PER_THREAD 4
+// Minimum number of destination bytes per band, smaller bands cost more in synchronization than they gain
+#define MIN_BAND_BYTES (64 * 1024)
+
+// One scaleSWParallel call, split into bands of whole line groups
+// A group is one source line and its yScale copies when upscaling, or one destination line and its -yScale source lines when downscaling
+typedef struct
+{
+	unsigned char* source;
+	unsigned char* destination;
+	int sourceWidth, sourceHeight;
+	int x, y, width, height;
+	int destinationWidth, destinationHeight;
+	int xScale, yScale;
+	int bandGroups;
+	int bandCount;
+	int nextBand;
+} ScaleJob;
+
+typedef struct
+{
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+	// Serializes callers, the pool runs one job at a time
+	pthread_mutex_t call;
+	int threads;
+	unsigned generation;
+	int pending;
+	ScaleJob* job;
+} ThreadPool;
+
+static ThreadPool pool = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_MUTEX_INITIALIZER, 0, 0, 0, NULL };
+static pthread_once_t poolOnce = PTHREAD_ONCE_INIT;
+
+// Take bands until none are left, each band scales its own destination lines so no locking is needed
+static void runBands(ScaleJob* job)
+{
+	int band;
+	while ((band = __atomic_fetch_add(&job->nextBand, 1, __ATOMIC_RELAXED)) < job->bandCount)
+	{
+		int first = band * job->bandGroups;
+		int groups = job->bandGroups;
+		int sourceFirst, sourceLines, destinationFirst, destinationLines;
+
+		if (job->yScale > 0)
+		{
+			if (first + groups > job->height) { groups = job->height - first; }
+			sourceFirst = first;
+			sourceLines = groups;
+			destinationFirst = first * job->yScale;
+			destinationLines = groups * job->yScale;
+		}
+		else
+		{
+			if (first + groups > job->destinationHeight) { groups = job->destinationHeight - first; }
+			sourceFirst = first * -job->yScale;
+			sourceLines = groups * -job->yScale;
+			if (sourceFirst + sourceLines > job->height) { sourceLines = job->height - sourceFirst; }
+			destinationFirst = first;
+			destinationLines = groups;
+		}
+
+		scaleSW(job->source, &job->destination[PIXEL(0, destinationFirst, job->destinationWidth)], job->sourceWidth, job->sourceHeight, job->x, job->y + sourceFirst, job->width, sourceLines, job->destinationWidth, destinationLines, job->xScale, job->yScale);
+	}
+}
+
+static void* workerMain(void* arg)
+{
+	unsigned seen = 0;
+
+	for (;;)
+	{
+		pthread_mutex_lock(&pool.lock);
+		while (pool.generation == seen) { pthread_cond_wait(&pool.start, &pool.lock); }
+		seen = pool.generation;
+		ScaleJob* job = pool.job;
+		pthread_mutex_unlock(&pool.lock);
+
+		runBands(job);
+
+		pthread_mutex_lock(&pool.lock);
+		if (--pool.pending == 0) { pthread_cond_signal(&pool.done); }
+		pthread_mutex_unlock(&pool.lock);
+	}
+
+	return NULL;
+}
+
+// Start workers, HOST_SW_THREADS overrides the number of online processors, the calling thread counts as one of them
+static void poolInit()
+{
+	char* env = getenv("HOST_SW_THREADS");
+	int threads = env != NULL ? atoi(env) : (int)sysconf(_SC_NPROCESSORS_ONLN);
+	if (threads < 1) { threads = 1; }
+
+	pool.threads = 1;
+	for (int i = 1; i < threads; i++)
+	{
+		pthread_t thread;
+		if (pthread_create(&thread, NULL, workerMain, NULL) != 0) { break; }
+		pthread_detach(thread);
+		pool.threads++;
+	}
+}
+
+void scaleSWParallel(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	pthread_once(&poolOnce, poolInit);
+
+	// Split into line groups, see ScaleJob
+	int groups = yScale > 0 ? height : destinationHeight;
+	int groupBytes = destinationWidth * (yScale > 0 ? yScale : 1);
+	int bandGroups = (groups + pool.threads * BANDS_PER_THREAD - 1) / (pool.threads * BANDS_PER_THREAD);
+	int minGroups = (MIN_BAND_BYTES + groupBytes - 1) / groupBytes;
+	if (bandGroups < minGroups) { bandGroups = minGroups; }
+
+	ScaleJob job = { source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale, bandGroups, (groups + bandGroups - 1) / bandGroups, 0 };
+
+	// Not worth waking the pool
+	if (pool.threads == 1 || job.bandCount <= 1)
+	{
+		scaleSW(source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale);
+		return;
+	}
+
+	pthread_mutex_lock(&pool.call);
+
+	pthread_mutex_lock(&pool.lock);
+	pool.job = &job;
+	pool.pending = pool.threads - 1;
+	pool.generation++;
+	pthread_cond_broadcast(&pool.start);
+	pthread_mutex_unlock(&pool.lock);
+
+	runBands(&job);
+
+	// Workers hold a pointer to the job on our stack until they report back
+	pthread_mutex_lock(&pool.lock);
+	while (pool.pending > 0) { pthread_cond_wait(&pool.done, &pool.lock); }
+	pthread_mutex_unlock(&pool.lock);
+
+	pthread_mutex_unlock(&pool.call);
+}
+
+#else
+
+// No threads on this target, run on the calling thread
+void scaleSWParallel(unsigned char* source, unsigned char* destination, int sourceWidth, int sourceHeight, int x, int y, int width, int height, int destinationWidth, int destinationHeight, int xScale, int yScale)
+{
+	scaleSW(source, destination, sourceWidth, sourceHeight, x, y, width, height, destinationWidth, destinationHeight, xScale, yScale);
+}
+
+#endif
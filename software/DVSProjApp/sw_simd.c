@@ -0,0 +1,356 @@
+#include "sw_simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// Kernel selection must be thread safe where scaleSWParallel runs a thread pool, SW_THREADS is set by the host build
+#ifndef SW_THREADS
+#define SW_THREADS 0
+#endif
+
+#if SW_THREADS
+#include <pthread.h>
+#endif
+
+// Macro to map scale factors {-4, -3, -2, -1, 1, 2, 3, 4} to kernel table index
+#define SCALE_IDX(scale) ((scale) < 0 ? (scale) + 4 : (scale) + 3)
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+// SSE2, unpack replicates bytes, pack gathers them
+
+__attribute__((target("sse2")))
+static int upscale2SSE2(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16, destination += 32)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)&source[i]);
+		_mm_storeu_si128((__m128i*)&destination[0],  _mm_unpacklo_epi8(v, v));
+		_mm_storeu_si128((__m128i*)&destination[16], _mm_unpackhi_epi8(v, v));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static int upscale4SSE2(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16, destination += 64)
+	{
+		__m128i v  = _mm_loadu_si128((const __m128i*)&source[i]);
+		__m128i lo = _mm_unpacklo_epi8(v, v);
+		__m128i hi = _mm_unpackhi_epi8(v, v);
+		_mm_storeu_si128((__m128i*)&destination[0],  _mm_unpacklo_epi16(lo, lo));
+		_mm_storeu_si128((__m128i*)&destination[16], _mm_unpackhi_epi16(lo, lo));
+		_mm_storeu_si128((__m128i*)&destination[32], _mm_unpacklo_epi16(hi, hi));
+		_mm_storeu_si128((__m128i*)&destination[48], _mm_unpackhi_epi16(hi, hi));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static int downscale2SSE2(const unsigned char* source, unsigned char* destination, int width)
+{
+	__m128i mask = _mm_set1_epi16(0x00FF);
+	int i = 0;
+	for (; i + 32 <= width; i += 32, destination += 16)
+	{
+		__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)&source[i]),      mask);
+		__m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)&source[i + 16]), mask);
+		_mm_storeu_si128((__m128i*)destination, _mm_packus_epi16(a, b));
+	}
+	return i;
+}
+
+__attribute__((target("sse2")))
+static int downscale4SSE2(const unsigned char* source, unsigned char* destination, int width)
+{
+	__m128i mask = _mm_set1_epi32(0x000000FF);
+	int i = 0;
+	for (; i + 64 <= width; i += 64, destination += 16)
+	{
+		__m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i*)&source[i]),      mask);
+		__m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i*)&source[i + 16]), mask);
+		__m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i*)&source[i + 32]), mask);
+		__m128i d = _mm_and_si128(_mm_loadu_si128((const __m128i*)&source[i + 48]), mask);
+		// Values fit in a byte, so signed saturation of the first pack never kicks in
+		_mm_storeu_si128((__m128i*)destination, _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+	}
+	return i;
+}
+
+// SSSE3, pshufb expands or gathers any factor with precomputed masks
+
+// Shuffle masks for upscaling, mask j produces output bytes 16 * j to 16 * j + 15 from 16 source bytes
+static unsigned char upMasks[5][4][16];
+// Shuffle masks for downscaling, mask l picks output bytes from source block l, 0x80 zeroes bytes from other blocks
+static unsigned char downMasks[5][4][16];
+
+static void initMasks()
+{
+	for (int k = 1; k <= 4; k++)
+	{
+		for (int j = 0; j < k; j++)
+		{
+			for (int t = 0; t < 16; t++)
+			{
+				upMasks[k][j][t] = (16 * j + t) / k;
+				downMasks[k][j][t] = (t * k) / 16 == j ? (t * k) % 16 : 0x80;
+			}
+		}
+	}
+}
+
+__attribute__((target("ssse3")))
+static inline int upscaleSSSE3(const unsigned char* source, unsigned char* destination, int width, int k)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)&source[i]);
+		for (int j = 0; j < k; j++, destination += 16)
+		{
+			_mm_storeu_si128((__m128i*)destination, _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)upMasks[k][j])));
+		}
+	}
+	return i;
+}
+
+__attribute__((target("ssse3")))
+static inline int downscaleSSSE3(const unsigned char* source, unsigned char* destination, int width, int k)
+{
+	int i = 0;
+	for (; i + 16 * k <= width; i += 16 * k, destination += 16)
+	{
+		__m128i out = _mm_setzero_si128();
+		for (int l = 0; l < k; l++)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)&source[i + 16 * l]);
+			out = _mm_or_si128(out, _mm_shuffle_epi8(v, _mm_loadu_si128((const __m128i*)downMasks[k][l])));
+		}
+		_mm_storeu_si128((__m128i*)destination, out);
+	}
+	return i;
+}
+
+// Instantiate with a constant factor so the inner loops are unrolled
+__attribute__((target("ssse3"))) static int upscale3SSSE3(const unsigned char* s, unsigned char* d, int w) { return upscaleSSSE3(s, d, w, 3); }
+__attribute__((target("ssse3"))) static int downscale3SSSE3(const unsigned char* s, unsigned char* d, int w) { return downscaleSSSE3(s, d, w, 3); }
+
+// AVX2, vpshufb only shuffles within 128-bit lanes
+// For upscaling each 32 byte output needs at most 16 consecutive source bytes, which are broadcast to both lanes
+
+// Shuffle masks for upscaling, mask j produces output bytes 32 * j to 32 * j + 31 relative to source byte (32 * j) / k
+static unsigned char upMasks256[5][4][32];
+
+static void initMasks256()
+{
+	for (int k = 1; k <= 4; k++)
+	{
+		for (int j = 0; j < k; j++)
+		{
+			for (int t = 0; t < 32; t++)
+			{
+				upMasks256[k][j][t] = (32 * j + t) / k - (32 * j) / k;
+			}
+		}
+	}
+}
+
+__attribute__((target("avx2")))
+static inline int upscaleAVX2(const unsigned char* source, unsigned char* destination, int width, int k)
+{
+	int i = 0;
+	// Source windows of the last output of a block can reach 16 bytes past the block start of that output
+	for (; i + 48 <= width; i += 32)
+	{
+		for (int j = 0; j < k; j++, destination += 32)
+		{
+			__m256i v = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)&source[i + (32 * j) / k]));
+			_mm256_storeu_si256((__m256i*)destination, _mm256_shuffle_epi8(v, _mm256_loadu_si256((const __m256i*)upMasks256[k][j])));
+		}
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int downscale2AVX2(const unsigned char* source, unsigned char* destination, int width)
+{
+	__m256i mask = _mm256_set1_epi16(0x00FF);
+	int i = 0;
+	for (; i + 64 <= width; i += 64, destination += 32)
+	{
+		__m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&source[i]),      mask);
+		__m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&source[i + 32]), mask);
+		// Packing works per lane, restore order of 64-bit quarters afterwards
+		_mm256_storeu_si256((__m256i*)destination, _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+	}
+	return i;
+}
+
+__attribute__((target("avx2")))
+static int downscale4AVX2(const unsigned char* source, unsigned char* destination, int width)
+{
+	__m256i mask = _mm256_set1_epi32(0x000000FF);
+	__m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+	int i = 0;
+	for (; i + 128 <= width; i += 128, destination += 32)
+	{
+		__m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&source[i]),      mask);
+		__m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&source[i + 32]), mask);
+		__m256i c = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&source[i + 64]), mask);
+		__m256i d = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)&source[i + 96]), mask);
+		__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(a, b), _mm256_packs_epi32(c, d));
+		// Packing works per lane, restore order of 32-bit groups afterwards
+		_mm256_storeu_si256((__m256i*)destination, _mm256_permutevar8x32_epi32(packed, order));
+	}
+	return i;
+}
+
+__attribute__((target("avx2"))) static int upscale2AVX2(const unsigned char* s, unsigned char* d, int w) { return upscaleAVX2(s, d, w, 2); }
+__attribute__((target("avx2"))) static int upscale3AVX2(const unsigned char* s, unsigned char* d, int w) { return upscaleAVX2(s, d, w, 3); }
+__attribute__((target("avx2"))) static int upscale4AVX2(const unsigned char* s, unsigned char* d, int w) { return upscaleAVX2(s, d, w, 4); }
+
+// Pick the widest kernel the CPU supports for each factor, HOST_SW_SIMD can cap the level to none, sse2, ssse3 or avx2
+static void selectKernels(SIMDLineKernel* kernels)
+{
+	char* cap = getenv("HOST_SW_SIMD");
+	int level = 3;
+	if (cap != NULL && strcmp(cap, "none") == 0)  { level = 0; }
+	if (cap != NULL && strcmp(cap, "sse2") == 0)  { level = 1; }
+	if (cap != NULL && strcmp(cap, "ssse3") == 0) { level = 2; }
+
+	__builtin_cpu_init();
+
+	if (level >= 1 && __builtin_cpu_supports("sse2"))
+	{
+		kernels[SCALE_IDX(-4)] = downscale4SSE2;
+		kernels[SCALE_IDX(-2)] = downscale2SSE2;
+		kernels[SCALE_IDX(2)]  = upscale2SSE2;
+		kernels[SCALE_IDX(4)]  = upscale4SSE2;
+	}
+	if (level >= 2 && __builtin_cpu_supports("ssse3"))
+	{
+		// Unpack and pack already cover factors 2 and 4 without loading masks
+		initMasks();
+		kernels[SCALE_IDX(-3)] = downscale3SSSE3;
+		kernels[SCALE_IDX(3)]  = upscale3SSSE3;
+	}
+	if (level >= 3 && __builtin_cpu_supports("avx2"))
+	{
+		initMasks256();
+		kernels[SCALE_IDX(-4)] = downscale4AVX2;
+		kernels[SCALE_IDX(-2)] = downscale2AVX2;
+		kernels[SCALE_IDX(2)]  = upscale2AVX2;
+		kernels[SCALE_IDX(3)]  = upscale3AVX2;
+		kernels[SCALE_IDX(4)]  = upscale4AVX2;
+	}
+}
+
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+// NEON, interleaving stores replicate bytes and de-interleaving loads gather them
+
+static int upscale2NEON(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16, destination += 32)
+	{
+		uint8x16_t v = vld1q_u8(&source[i]);
+		uint8x16x2_t out = { { v, v } };
+		vst2q_u8(destination, out);
+	}
+	return i;
+}
+
+static int upscale3NEON(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16, destination += 48)
+	{
+		uint8x16_t v = vld1q_u8(&source[i]);
+		uint8x16x3_t out = { { v, v, v } };
+		vst3q_u8(destination, out);
+	}
+	return i;
+}
+
+static int upscale4NEON(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 16 <= width; i += 16, destination += 64)
+	{
+		uint8x16_t v = vld1q_u8(&source[i]);
+		uint8x16x4_t out = { { v, v, v, v } };
+		vst4q_u8(destination, out);
+	}
+	return i;
+}
+
+static int downscale2NEON(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 32 <= width; i += 32, destination += 16) { vst1q_u8(destination, vld2q_u8(&source[i]).val[0]); }
+	return i;
+}
+
+static int downscale3NEON(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 48 <= width; i += 48, destination += 16) { vst1q_u8(destination, vld3q_u8(&source[i]).val[0]); }
+	return i;
+}
+
+static int downscale4NEON(const unsigned char* source, unsigned char* destination, int width)
+{
+	int i = 0;
+	for (; i + 64 <= width; i += 64, destination += 16) { vst1q_u8(destination, vld4q_u8(&source[i]).val[0]); }
+	return i;
+}
+
+// NEON is part of the base architecture, HOST_SW_SIMD=none disables it
+static void selectKernels(SIMDLineKernel* kernels)
+{
+	char* cap = getenv("HOST_SW_SIMD");
+	if (cap != NULL && strcmp(cap, "none") == 0) { return; }
+
+	kernels[SCALE_IDX(-4)] = downscale4NEON;
+	kernels[SCALE_IDX(-3)] = downscale3NEON;
+	kernels[SCALE_IDX(-2)] = downscale2NEON;
+	kernels[SCALE_IDX(2)]  = upscale2NEON;
+	kernels[SCALE_IDX(3)]  = upscale3NEON;
+	kernels[SCALE_IDX(4)]  = upscale4NEON;
+}
+
+#else
+
+// No vector unit, scalar code handles everything
+static void selectKernels(SIMDLineKernel* kernels) {}
+
+#endif
+
+static SIMDLineKernel kernels[8];
+
+static void selectAllKernels()
+{
+	selectKernels(kernels);
+}
+
+SIMDLineKernel simdLineKernel(int xScale)
+{
+#if SW_THREADS
+	// Band threads of scaleSWParallel can make the first call together, only one of them may fill the table
+	static pthread_once_t kernelsOnce = PTHREAD_ONCE_INIT;
+	pthread_once(&kernelsOnce, selectAllKernels);
+#else
+	static int selected = 0;
+	if (!selected) { selectAllKernels(); selected = 1; }
+#endif
+
+	return kernels[SCALE_IDX(xScale)];
+}
@@ -0,0 +1,14 @@
+#ifndef SW_SIMD_H_
+#define SW_SIMD_H_
+
+// Vector line scaling kernels for host builds, selected at runtime from what the CPU supports
+
+// Kernel scales as many whole vector blocks of the line as fit and returns the number of source pixels consumed
+// For downscaling the count is a multiple of the scale factor, so the rest of the line can be continued by scalar code
+typedef int (*SIMDLineKernel)(const unsigned char* source, unsigned char* destination, int width);
+
+// Kernel for one scale factor, NULL when there is none, which is always the case on Nios II
+// Kernels are selected once on the first call, which may come from several threads at the same time
+SIMDLineKernel simdLineKernel(int xScale);
+
+#endif /* SW_SIMD_H_ */
@@ -0,0 +1,25 @@
+#ifndef __PERFORMANCE_COUNTER_H__
+#define __PERFORMANCE_COUNTER_H__
+
+// Host stand-in for the performance counter driver
+// Register writes are decoded by host_perf.c, which timestamps them with the host monotonic clock
+
+#include "alt_types.h"
+#include "io.h"
+
+// uses counter #0 as the global time-counter.
+#define PERF_BEGIN(p,n) IOWR((p),(((n)*4)+1),0)
+#define PERF_END(p,n)   IOWR((p),(((n)*4)  ),0)
+
+#define PERF_RESET(p) IOWR((p),0,1)
+#define PERF_START_MEASURING(p) PERF_BEGIN ((p),0)
+#define PERF_STOP_MEASURING(p)  PERF_END   ((p),0)
+
+// Base address is taken as an integer since system.h defines it as one
+alt_u64 perf_get_total_time   (alt_u32 hw_base_address);
+alt_u64 perf_get_section_time (alt_u32 hw_base_address, int which_section);
+alt_u32 perf_get_num_starts   (alt_u32 hw_base_address, int which_section);
+
+int perf_print_formatted_report (alt_u32 perf_base, alt_u32 clock_freq_hertz, int num_sections, ...);
+
+#endif /* __PERFORMANCE_COUNTER_H__ */
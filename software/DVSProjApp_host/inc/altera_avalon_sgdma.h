@@ -0,0 +1,59 @@
+#ifndef __ALTERA_AVALON_SGDMA_H__
+#define __ALTERA_AVALON_SGDMA_H__
+
+// Host stand-in for the SGDMA driver
+// Same public API as ../DVSProjApp_bsp/drivers/inc/altera_avalon_sgdma.h, transfers are carried out by host_sgdma.c
+
+#include <stddef.h>
+#include <errno.h>
+
+#include "alt_types.h"
+#include "io.h"
+#include "altera_avalon_sgdma_descriptor.h"
+
+// Callback routine type definition
+typedef void (*alt_avalon_sgdma_callback)(void *context);
+
+// SGDMA Device Structure
+typedef struct alt_sgdma_dev
+{
+  const char                *name;               // Name of SGDMA in SOPC System
+  alt_u32                   base;                // Base address of SGDMA
+  alt_avalon_sgdma_callback callback;            // Callback routine pointer
+  void                      *callback_context;   // Callback context pointer
+  alt_u32                   chain_control;       // Value OR'd into control reg
+  alt_u32                   control;             // Host model of control register
+  alt_u32                   status;              // Host model of status register
+  alt_sgdma_descriptor      *chain;              // Descriptor the controller was started on
+} alt_sgdma_dev;
+
+int alt_avalon_sgdma_do_async_transfer(alt_sgdma_dev *dev, alt_sgdma_descriptor *desc);
+
+void alt_avalon_sgdma_construct_stream_to_mem_desc(
+  alt_sgdma_descriptor *desc,
+  alt_sgdma_descriptor *next,
+  alt_u32              *write_addr,
+  alt_u16               length_or_eop,
+  int                   write_fixed);
+
+void alt_avalon_sgdma_construct_mem_to_stream_desc(
+  alt_sgdma_descriptor *desc,
+  alt_sgdma_descriptor *next,
+  alt_u32              *read_addr,
+  alt_u16               length,
+  int                   read_fixed,
+  int                   generate_sop,
+  int                   generate_eop,
+  alt_u8                atlantic_channel);
+
+void alt_avalon_sgdma_register_callback(
+  alt_sgdma_dev *dev,
+  alt_avalon_sgdma_callback callback,
+  alt_u32 chain_control,
+  void *context);
+
+void alt_avalon_sgdma_stop(alt_sgdma_dev *dev);
+
+alt_sgdma_dev* alt_avalon_sgdma_open(const char* name);
+
+#endif /* __ALTERA_AVALON_SGDMA_H__ */
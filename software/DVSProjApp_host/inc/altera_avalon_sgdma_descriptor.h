@@ -0,0 +1,61 @@
+#ifndef __ALTERA_AVALON_SGDMA_DESCRIPTOR_H__
+#define __ALTERA_AVALON_SGDMA_DESCRIPTOR_H__
+
+// Host stand-in for the SGDMA driver descriptor definitions
+
+#include "alt_types.h"
+
+// Each Scatter-gather DMA buffer descriptor spans 0x20 of memory
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE (0x20)
+
+// Descriptor control bit masks & offsets
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_GENERATE_EOP_MSK (0x1)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_GENERATE_EOP_OFST (0)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_READ_FIXED_ADDRESS_MSK (0x2)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_READ_FIXED_ADDRESS_OFST (1)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_WRITE_FIXED_ADDRESS_MSK (0x4)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_WRITE_FIXED_ADDRESS_OFST (2)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_ATLANTIC_CHANNEL_MSK (0x8)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_ATLANTIC_CHANNEL_OFST (3)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK (0x80)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_OFST (7)
+
+// Descriptor status bit masks & offsets
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_STATUS_E_OVERFLOW_MSK (0x4)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_STATUS_E_OVERFLOW_OFST (2)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_STATUS_TERMINATED_BY_EOP_MSK (0x80)
+#define ALTERA_AVALON_SGDMA_DESCRIPTOR_STATUS_TERMINATED_BY_EOP_OFST (7)
+
+#define alt_avalon_sgdma_packed __attribute__ ((packed,aligned(1)))
+
+// The controller allocates 64 bits for each address
+// On 64-bit hosts pointers fill that space by themselves, on 32-bit hosts they are padded as on Nios II
+typedef struct {
+    alt_u32   *read_addr;
+#if UINTPTR_MAX == 0xFFFFFFFFu
+    alt_u32   read_addr_pad;
+#endif
+
+    alt_u32   *write_addr;
+#if UINTPTR_MAX == 0xFFFFFFFFu
+    alt_u32   write_addr_pad;
+#endif
+
+    alt_u32   *next;
+#if UINTPTR_MAX == 0xFFFFFFFFu
+    alt_u32   next_pad;
+#endif
+
+    alt_u16   bytes_to_transfer;
+    alt_u8    read_burst;
+    alt_u8    write_burst;
+
+    alt_u16   actual_bytes_transferred;
+    alt_u8    status;
+    alt_u8    control;
+
+} alt_avalon_sgdma_packed alt_sgdma_descriptor;
+
+_Static_assert(sizeof(alt_sgdma_descriptor) == ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE, "Descriptor does not match hardware layout");
+
+#endif /* __ALTERA_AVALON_SGDMA_DESCRIPTOR_H__ */
@@ -0,0 +1,22 @@
+#ifndef __ALTERA_AVALON_SGDMA_REGS_H__
+#define __ALTERA_AVALON_SGDMA_REGS_H__
+
+// Host stand-in for the SGDMA driver register definitions, only bit masks are needed
+
+#define ALTERA_AVALON_SGDMA_STATUS_ERROR_MSK                        (0x1)
+#define ALTERA_AVALON_SGDMA_STATUS_EOP_ENCOUNTERED_MSK              (0x2)
+#define ALTERA_AVALON_SGDMA_STATUS_DESC_COMPLETED_MSK               (0x4)
+#define ALTERA_AVALON_SGDMA_STATUS_CHAIN_COMPLETED_MSK              (0x8)
+#define ALTERA_AVALON_SGDMA_STATUS_BUSY_MSK                         (0x10)
+
+#define ALTERA_AVALON_SGDMA_CONTROL_IE_ERROR_MSK                     (0x1)
+#define ALTERA_AVALON_SGDMA_CONTROL_IE_EOP_ENCOUNTERED_MSK           (0x2)
+#define ALTERA_AVALON_SGDMA_CONTROL_IE_DESC_COMPLETED_MSK            (0x4)
+#define ALTERA_AVALON_SGDMA_CONTROL_IE_CHAIN_COMPLETED_MSK           (0x8)
+#define ALTERA_AVALON_SGDMA_CONTROL_IE_GLOBAL_MSK                    (0x10)
+#define ALTERA_AVALON_SGDMA_CONTROL_RUN_MSK                          (0x20)
+#define ALTERA_AVALON_SGDMA_CONTROL_STOP_DMA_ER_MSK                  (0x40)
+#define ALTERA_AVALON_SGDMA_CONTROL_PARK_MSK                         (0X20000)
+#define ALTERA_AVALON_SGDMA_CONTROL_CLEAR_INTERRUPT_MSK              (0X80000000)
+
+#endif /* __ALTERA_AVALON_SGDMA_REGS_H__ */
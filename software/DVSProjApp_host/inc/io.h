@@ -0,0 +1,21 @@
+#ifndef __IO_H__
+#define __IO_H__
+
+// Host stand-in for the HAL io.h
+// Register accesses are routed to software models of the peripherals instead of the bus
+
+#include "alt_types.h"
+
+#define SYSTEM_BUS_WIDTH 32
+
+void hostIoWrite(alt_u32 address, alt_u32 data);
+alt_u32 hostIoRead(alt_u32 address);
+
+// Addresses are byte addresses for DIRECT accessors and register indices for IORD/IOWR, same as on Nios II
+#define IORD_32DIRECT(BASE, OFFSET)       hostIoRead((alt_u32)(BASE) + (OFFSET))
+#define IOWR_32DIRECT(BASE, OFFSET, DATA) hostIoWrite((alt_u32)(BASE) + (OFFSET), (DATA))
+
+#define IORD(BASE, REGNUM)       IORD_32DIRECT((BASE), (REGNUM) * (SYSTEM_BUS_WIDTH / 8))
+#define IOWR(BASE, REGNUM, DATA) IOWR_32DIRECT((BASE), (REGNUM) * (SYSTEM_BUS_WIDTH / 8), (DATA))
+
+#endif /* __IO_H__ */
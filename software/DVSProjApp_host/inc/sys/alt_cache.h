@@ -0,0 +1,18 @@
+#ifndef __ALT_CACHE_H__
+#define __ALT_CACHE_H__
+
+// Host stand-in for the HAL sys/alt_cache.h
+// Host DMA models access memory through the CPU, so all maintenance operations are no-ops
+
+#include <stddef.h>
+
+#include "alt_types.h"
+
+void alt_dcache_flush(void* start, alt_u32 len);
+void alt_dcache_flush_no_writeback(void* start, alt_u32 len);
+void alt_dcache_flush_all(void);
+volatile void* alt_uncached_malloc(size_t size);
+void alt_uncached_free(volatile void* ptr);
+volatile void* alt_remap_uncached(void* ptr, alt_u32 len);
+
+#endif /* __ALT_CACHE_H__ */
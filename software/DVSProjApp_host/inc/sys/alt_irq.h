@@ -0,0 +1,15 @@
+#ifndef __ALT_IRQ_H__
+#define __ALT_IRQ_H__
+
+// Host stand-in for the HAL sys/alt_irq.h
+// SGDMA completion interrupts are raised from an interrupt thread, disabling interrupts holds that thread off
+// Every disable must be paired with an enable in the same thread, as the HAL drivers do
+
+#include "alt_types.h"
+
+typedef alt_u32 alt_irq_context;
+
+alt_irq_context alt_irq_disable_all(void);
+void alt_irq_enable_all(alt_irq_context context);
+
+#endif /* __ALT_IRQ_H__ */
@@ -0,0 +1,39 @@
+#ifndef __SYSTEM_H_
+#define __SYSTEM_H_
+
+// Host stand-in for the BSP generated system.h
+// Only the definitions used by the application are provided, names and addresses match ../DVSProjApp_bsp/system.h
+
+// CPU, same clock as the board so that cycle counts and pixels per cycle compare with board results
+// The performance counter runs off the host monotonic clock converted to ticks of this clock
+#define ALT_CPU_CPU_FREQ 100000000u
+#define ALT_CPU_FREQ 100000000
+#define ALT_CPU_DCACHE_LINE_SIZE 0
+#define ALT_CPU_DCACHE_SIZE 0
+#define NIOS2_DCACHE_LINE_SIZE 0
+#define NIOS2_DCACHE_SIZE 0
+
+// acc_scale
+#define ACC_SCALE_BASE 0x8001108
+#define ACC_SCALE_NAME "/dev/acc_scale"
+#define ACC_SCALE_SPAN 8
+
+// perf_cnt
+#define PERF_CNT_BASE 0x8001000
+#define PERF_CNT_HOW_MANY_SECTIONS 7
+#define PERF_CNT_NAME "/dev/perf_cnt"
+#define PERF_CNT_SPAN 128
+
+// sdram, only its size is used, host memory is allocated with malloc
+#define SDRAM_BASE 0x4000000
+#define SDRAM_SPAN 67108864
+
+// sgdma_m2s
+#define SGDMA_M2S_BASE 0x80010c0
+#define SGDMA_M2S_NAME "/dev/sgdma_m2s"
+
+// sgdma_s2m
+#define SGDMA_S2M_BASE 0x8001080
+#define SGDMA_S2M_NAME "/dev/sgdma_s2m"
+
+#endif /* __SYSTEM_H_ */
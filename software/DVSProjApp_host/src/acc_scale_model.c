@@ -0,0 +1,207 @@
+#include "acc_scale_model.h"
+
+#include <string.h>
+
+// Memory Map
+#define CR_ADDR 0
+#define WH_ADDR 4
+
+// Control and Status Register Map
+#define X_SCALE_OFFSET 0
+#define X_UPSCALE_OFFSET 2
+#define Y_SCALE_OFFSET 3
+#define Y_UPSCALE_OFFSET 5
+
+// Width and Height Register Map
+#define WIDTH_OFFSET 0
+#define HEIGHT_OFFSET 16
+
+// Counters wrap the same way as their VHDL unsigned counterparts
+#define U16(v) ((alt_u16)(v))
+#define U3(v) ((alt_u8)((v) & 7))
+
+static void resetCounter(AccCounter* counter)
+{
+	counter->pixelRep = 0;
+	counter->pixel    = 0;
+	counter->rowRep   = 0;
+	counter->row      = 0;
+}
+
+// image_counter next_pixel step, scales are actual values
+static void stepCounter(AccCounter* counter, int xUpscale, int xScale, int yUpscale, int yScale, alt_u16 width)
+{
+	// Increment pixel repetition either way, if downscaling it will be reset
+	alt_u8 pixelRep = U3(counter->pixelRep + 1);
+	alt_u16 pixel   = counter->pixel;
+	alt_u8 rowRep   = counter->rowRep;
+	alt_u16 row     = counter->row;
+
+	if (!xUpscale)               { pixelRep = 0; pixel = U16(pixel + xScale); }
+	else if (pixelRep == xScale) { pixelRep = 0; pixel = U16(pixel + 1); }
+
+	if (pixel >= width)
+	{
+		// Past the end of the line, reset pixel counter and increment row repetition counter
+		pixel  = 0;
+		rowRep = U3(rowRep + 1);
+
+		if (!yUpscale)             { rowRep = 0; row = U16(row + yScale); }
+		else if (rowRep == yScale) { rowRep = 0; row = U16(row + 1); }
+	}
+
+	counter->pixelRep = pixelRep;
+	counter->pixel    = pixel;
+	counter->rowRep   = rowRep;
+	counter->row      = row;
+}
+
+void accModelReset(AccScaleModel* model)
+{
+	memset(model, 0, sizeof(AccScaleModel));
+}
+
+void accModelWrite(AccScaleModel* model, alt_u32 offset, alt_u32 data)
+{
+	if (offset == CR_ADDR)
+	{
+		model->yUpscale = (data >> Y_UPSCALE_OFFSET) & 1;
+		model->yScale   = (data >> Y_SCALE_OFFSET) & 3;
+		model->xUpscale = (data >> X_UPSCALE_OFFSET) & 1;
+		model->xScale   = (data >> X_SCALE_OFFSET) & 3;
+	}
+	else if (offset == WH_ADDR)
+	{
+		model->height = (data >> HEIGHT_OFFSET) & 0xFFFF;
+		model->width  = (data >> WIDTH_OFFSET) & 0xFFFF;
+	}
+	else
+	{
+		return;
+	}
+
+	// Register strobes reset both counters, start collecting statistics for the new job
+	resetCounter(&model->stream);
+	resetCounter(&model->output);
+	memset(&model->stats, 0, sizeof(AccStats));
+	model->frameStart = 0;
+}
+
+alt_u32 accModelRead(AccScaleModel* model, alt_u32 offset)
+{
+	if (offset == CR_ADDR)
+	{
+		return model->yUpscale << Y_UPSCALE_OFFSET | model->yScale << Y_SCALE_OFFSET | model->xUpscale << X_UPSCALE_OFFSET | model->xScale << X_SCALE_OFFSET;
+	}
+	if (offset == WH_ADDR)
+	{
+		return model->height << HEIGHT_OFFSET | model->width << WIDTH_OFFSET;
+	}
+	return 0;
+}
+
+// reader_last_rep
+static int readerLastRep(AccScaleModel* model)
+{
+	return model->output.rowRep == model->yScale || !model->yUpscale;
+}
+
+int accModelAsiReady(AccScaleModel* model)
+{
+	alt_u16 outputRow = model->output.row;
+	alt_u16 streamRow = model->stream.row;
+
+	// We can write pixel to buffer only if reader won't need the pixel we are overwriting
+	int readerRowAhead     = outputRow > streamRow;
+	int readerRowEqual     = outputRow == streamRow;
+	int readerRowOneBehind = outputRow == U16(streamRow - 1);
+	int readerPixelAhead   = model->output.pixel > model->stream.pixel;
+
+	return readerRowAhead || readerRowEqual || (readerRowOneBehind && readerLastRep(model) && readerPixelAhead);
+}
+
+int accModelAsoValid(AccScaleModel* model)
+{
+	// We can output pixel from the buffer only if writer has already written the corresponding pixel to buffer
+	int readerRowBehind   = model->output.row < model->stream.row;
+	int readerRowEqual    = model->output.row == model->stream.row;
+	int readerPixelBehind = model->output.pixel < model->stream.pixel;
+
+	return readerRowBehind || (readerRowEqual && readerPixelBehind);
+}
+
+alt_u8 accModelAsoData(AccScaleModel* model)
+{
+	return model->buffer[model->output.pixel & (ACC_MAX_WIDTH - 1)];
+}
+
+alt_u32 accModelOccupancy(AccScaleModel* model)
+{
+	alt_u64 written = (alt_u64)model->stream.row * model->width + model->stream.pixel;
+	alt_u64 read    = (alt_u64)model->output.row * model->width + model->output.pixel;
+	return written > read ? (alt_u32)(written - read) : 0;
+}
+
+int accModelClock(AccScaleModel* model, int asiValid, alt_u8 asiData, int asoReady)
+{
+	AccStats* stats = &model->stats;
+
+	// Evaluate combinational logic from current state
+	int asiReady   = accModelAsiReady(model);
+	int asoValid   = accModelAsoValid(model);
+	int streamNext = asiReady && asiValid;
+	int outputNext = asoReady && asoValid;
+
+	// Collect statistics for this cycle
+	alt_u32 occupancy = accModelOccupancy(model);
+	stats->cycles++;
+	stats->occupancySum += occupancy;
+	if (occupancy > stats->occupancyMax) { stats->occupancyMax = occupancy; }
+	if (asiValid && !asiReady) { stats->inputStalls++; }
+	if (asiReady && !asiValid) { stats->inputIdle++; }
+	if (asoValid && !asoReady) { stats->outputStalls++; }
+	if (asoReady && !asoValid) { stats->outputIdle++; }
+	if (streamNext) { stats->inputPixels++; }
+	if (outputNext) { stats->outputPixels++; }
+
+	// Rising edge, buffer write and counter updates
+	// Stream counter always runs at scale 1 since source image is not scaled
+	if (streamNext)
+	{
+		model->buffer[model->stream.pixel & (ACC_MAX_WIDTH - 1)] = asiData;
+		stepCounter(&model->stream, 0, 1, 0, 1, model->width);
+	}
+	if (outputNext)
+	{
+		stepCounter(&model->output, model->xUpscale, model->xScale + 1, model->yUpscale, model->yScale + 1, model->width);
+	}
+
+	// Reset counters once both have run off the end of the frame, the reset is asynchronous so it takes effect within this cycle
+	if (model->stream.row >= model->height && model->output.row >= model->height)
+	{
+		resetCounter(&model->stream);
+		resetCounter(&model->output);
+		stats->frames++;
+		stats->frameCycles = stats->cycles - model->frameStart;
+		model->frameStart = stats->cycles;
+	}
+
+	return streamNext || outputNext;
+}
+
+void accModelPrintStats(AccScaleModel* model, FILE* f)
+{
+	AccStats* stats = &model->stats;
+	alt_u64 cycles = stats->cycles ? stats->cycles : 1;
+
+	fprintf(f, "--acc_scale Model Report--\n");
+	fprintf(f, "Geometry:       %u x %u, x scale %s%d, y scale %s%d\n", model->width, model->height, model->xUpscale ? "" : "-", model->xScale + 1, model->yUpscale ? "" : "-", model->yScale + 1);
+	fprintf(f, "Cycles:         %llu (%llu frames, last frame %llu)\n", (unsigned long long)stats->cycles, (unsigned long long)stats->frames, (unsigned long long)stats->frameCycles);
+	fprintf(f, "Input pixels:   %llu (%.3f per cycle)\n", (unsigned long long)stats->inputPixels, (double)stats->inputPixels / cycles);
+	fprintf(f, "Output pixels:  %llu (%.3f per cycle)\n", (unsigned long long)stats->outputPixels, (double)stats->outputPixels / cycles);
+	fprintf(f, "asi_ready low:  %llu cycles with valid data (%.1f%%)\n", (unsigned long long)stats->inputStalls, 100.0 * stats->inputStalls / cycles);
+	fprintf(f, "asi_valid low:  %llu cycles while ready (%.1f%%)\n", (unsigned long long)stats->inputIdle, 100.0 * stats->inputIdle / cycles);
+	fprintf(f, "aso_ready low:  %llu cycles with valid data (%.1f%%)\n", (unsigned long long)stats->outputStalls, 100.0 * stats->outputStalls / cycles);
+	fprintf(f, "aso_valid low:  %llu cycles while ready (%.1f%%)\n", (unsigned long long)stats->outputIdle, 100.0 * stats->outputIdle / cycles);
+	fprintf(f, "Buffer:         %.1f average, %u maximum pixels\n", (double)stats->occupancySum / cycles, stats->occupancyMax);
+}
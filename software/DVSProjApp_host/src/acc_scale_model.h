@@ -0,0 +1,73 @@
+#ifndef ACC_SCALE_MODEL_H_
+#define ACC_SCALE_MODEL_H_
+
+#include <stdio.h>
+#include <alt_types.h>
+
+// Line buffer size, max_width generic of acc_scale
+#define ACC_MAX_WIDTH 1024
+
+// Registered state of one image_counter instance
+typedef struct
+{
+	alt_u8 pixelRep;
+	alt_u16 pixel;
+	alt_u8 rowRep;
+	alt_u16 row;
+} AccCounter;
+
+// Statistics collected while clocking the model, cleared on every register write
+typedef struct
+{
+	alt_u64 cycles;          // Cycles since last register write
+	alt_u64 frames;          // Completed frames
+	alt_u64 frameCycles;     // Cycles taken by last completed frame
+	alt_u64 inputPixels;     // Pixels accepted on asi
+	alt_u64 outputPixels;    // Pixels sent on aso
+	alt_u64 inputStalls;     // Cycles with asi_valid high and asi_ready low
+	alt_u64 outputStalls;    // Cycles with aso_valid high and aso_ready low
+	alt_u64 inputIdle;       // Cycles with asi_ready high and asi_valid low
+	alt_u64 outputIdle;      // Cycles with aso_ready high and aso_valid low
+	alt_u64 occupancySum;    // Sum of buffer occupancy over all cycles
+	alt_u32 occupancyMax;    // Maximum buffer occupancy
+} AccStats;
+
+// Cycle-accurate model of hdl/acc_scale.vhd
+// Combinational outputs are functions of current state, accModelClock advances state by one rising edge
+typedef struct
+{
+	// Control and Status Register, scales are in register encoding (actual - 1)
+	int xScale;
+	int xUpscale;
+	int yScale;
+	int yUpscale;
+	// Width and Height Register
+	alt_u16 width;
+	alt_u16 height;
+
+	AccCounter stream;
+	AccCounter output;
+	alt_u8 buffer[ACC_MAX_WIDTH];
+
+	alt_u64 frameStart;
+	AccStats stats;
+} AccScaleModel;
+
+void accModelReset(AccScaleModel* model);
+void accModelWrite(AccScaleModel* model, alt_u32 offset, alt_u32 data);
+alt_u32 accModelRead(AccScaleModel* model, alt_u32 offset);
+
+// Stream handshake signals for the current cycle
+int accModelAsiReady(AccScaleModel* model);
+int accModelAsoValid(AccScaleModel* model);
+alt_u8 accModelAsoData(AccScaleModel* model);
+
+// Advance one clock, returns 1 if any pixel moved on either stream
+int accModelClock(AccScaleModel* model, int asiValid, alt_u8 asiData, int asoReady);
+
+// Pixels written to the line buffer that the output side has not yet passed
+alt_u32 accModelOccupancy(AccScaleModel* model);
+
+void accModelPrintStats(AccScaleModel* model, FILE* f);
+
+#endif /* ACC_SCALE_MODEL_H_ */
@@ -0,0 +1,21 @@
+#include <system.h>
+
+#include "host_hal.h"
+
+// Single acc_scale instance in the system
+static AccScaleModel model;
+
+AccScaleModel* hostAccScaleModel(void)
+{
+	return &model;
+}
+
+void hostAccScaleWrite(alt_u32 offset, alt_u32 data)
+{
+	accModelWrite(&model, offset, data);
+}
+
+alt_u32 hostAccScaleRead(alt_u32 offset)
+{
+	return accModelRead(&model, offset);
+}
@@ -0,0 +1,26 @@
+#include <sys/alt_cache.h>
+
+#include <stdlib.h>
+
+// Host DMA models read and write memory through the CPU caches, so there is nothing to maintain
+
+void alt_dcache_flush(void* start, alt_u32 len) {}
+
+void alt_dcache_flush_no_writeback(void* start, alt_u32 len) {}
+
+void alt_dcache_flush_all(void) {}
+
+volatile void* alt_uncached_malloc(size_t size)
+{
+	return malloc(size);
+}
+
+void alt_uncached_free(volatile void* ptr)
+{
+	free((void*)ptr);
+}
+
+volatile void* alt_remap_uncached(void* ptr, alt_u32 len)
+{
+	return ptr;
+}
@@ -0,0 +1,52 @@
+#ifndef HOST_HAL_H_
+#define HOST_HAL_H_
+
+#include <stdio.h>
+#include <alt_types.h>
+
+#include "acc_scale_model.h"
+
+// Register interface of the peripheral models, offsets are byte offsets from peripheral base
+void hostPerfWrite(alt_u32 offset, alt_u32 data);
+alt_u32 hostPerfRead(alt_u32 offset);
+void hostAccScaleWrite(alt_u32 offset, alt_u32 data);
+alt_u32 hostAccScaleRead(alt_u32 offset);
+
+// Model behind ACC_SCALE_BASE, statistics are kept until the next register write
+AccScaleModel* hostAccScaleModel(void);
+
+// Performance counter time base, hostPerfAdvance moves it by the given number of ticks
+// Used to hide time spent simulating hardware, modelled hardware time then passes in real time
+alt_u64 hostPerfNow(void);
+void hostPerfAdvance(alt_64 ticks);
+
+// SGDMA and SDRAM timing parameters, read from environment on first use
+typedef struct
+{
+	int clockFreq;     // HOST_FABRIC_FREQ, clock of SGDMAs, acc_scale and SDRAM controller
+	int readLatency;   // HOST_SDRAM_READ_LATENCY, cycles the port is occupied by a single beat read
+	int writeLatency;  // HOST_SDRAM_WRITE_LATENCY, cycles the port is occupied by a single beat write
+	int turnaround;    // HOST_SDRAM_TURNAROUND, extra cycles when switching between reads and writes
+	int dataWidth;     // HOST_SGDMA_DATA_WIDTH, bytes per beat of the SGDMA memory masters
+	int burstLength;   // HOST_SGDMA_BURST, beats per transaction, each beat after the first costs one cycle
+	int fifoDepth;     // HOST_SGDMA_FIFO_DEPTH, bytes buffered between memory port and stream
+	int descOnchip;    // HOST_SGDMA_DESC_ONCHIP, descriptors are in on-chip memory and do not use the SDRAM port
+} HostSgdmaConfig;
+
+// Statistics of the last transfer
+typedef struct
+{
+	alt_u64 cycles;
+	alt_u64 descriptors;
+	alt_u64 transactions;
+	alt_u64 turnarounds;
+	alt_u64 bytesRead;
+	alt_u64 bytesWritten;
+	alt_u64 portBusy;
+} HostSgdmaStats;
+
+HostSgdmaConfig* hostSgdmaConfig(void);
+HostSgdmaStats* hostSgdmaStats(void);
+void hostSgdmaPrintStats(FILE* f);
+
+#endif /* HOST_HAL_H_ */
@@ -0,0 +1,24 @@
+#include <io.h>
+
+#include <stdio.h>
+#include <system.h>
+
+#include "host_hal.h"
+
+// Macro to check if address falls inside the span of a peripheral
+#define IN_SPAN(address, base, span) ((address) >= (base) && (address) < (base) + (span))
+
+void hostIoWrite(alt_u32 address, alt_u32 data)
+{
+	if (IN_SPAN(address, ACC_SCALE_BASE, ACC_SCALE_SPAN))     { hostAccScaleWrite(address - ACC_SCALE_BASE, data); }
+	else if (IN_SPAN(address, PERF_CNT_BASE, PERF_CNT_SPAN))  { hostPerfWrite(address - PERF_CNT_BASE, data); }
+	else                                                      { fprintf(stderr, "Write to unmapped address 0x%08x\n", (unsigned int)address); }
+}
+
+alt_u32 hostIoRead(alt_u32 address)
+{
+	if (IN_SPAN(address, ACC_SCALE_BASE, ACC_SCALE_SPAN))     { return hostAccScaleRead(address - ACC_SCALE_BASE); }
+	else if (IN_SPAN(address, PERF_CNT_BASE, PERF_CNT_SPAN))  { return hostPerfRead(address - PERF_CNT_BASE); }
+	else                                                      { fprintf(stderr, "Read from unmapped address 0x%08x\n", (unsigned int)address); }
+	return 0;
+}
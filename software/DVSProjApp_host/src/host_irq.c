@@ -0,0 +1,30 @@
+#include <sys/alt_irq.h>
+
+#include <pthread.h>
+
+// Interrupts are raised by the interrupt thread of host_sgdma.c, which runs the callbacks while holding this lock
+// Disabling interrupts takes the same lock, it is recursive so calls can nest like on the board, also inside callbacks
+
+static pthread_mutex_t irqLock;
+static pthread_once_t irqOnce = PTHREAD_ONCE_INIT;
+
+static void irqInit(void)
+{
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&irqLock, &attr);
+	pthread_mutexattr_destroy(&attr);
+}
+
+alt_irq_context alt_irq_disable_all(void)
+{
+	pthread_once(&irqOnce, irqInit);
+	pthread_mutex_lock(&irqLock);
+	return 0;
+}
+
+void alt_irq_enable_all(alt_irq_context context)
+{
+	pthread_mutex_unlock(&irqLock);
+}
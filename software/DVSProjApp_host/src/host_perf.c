@@ -0,0 +1,171 @@
+#include <altera_avalon_performance_counter.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <time.h>
+#include <system.h>
+
+#include "host_hal.h"
+
+// Each section occupies four registers, first two hold the time, third holds number of starts
+// Writing to the first register ends the section, writing to the second begins it
+// Writing 1 to the first register of section 0 resets the whole counter
+#define SECTION_REGS 4
+#define END_REG 0
+#define BEGIN_REG 1
+
+typedef struct
+{
+	alt_u64 time;
+	alt_u64 start;
+	alt_u32 starts;
+	int enabled;
+} PerfSection;
+
+// Section 0 is the global counter, like the global_enable of the counter RTL every other section only counts while it is enabled
+// Stopping the global counter leaves sections enabled, they resume counting when it is started again
+static PerfSection sections[PERF_CNT_HOW_MANY_SECTIONS + 1];
+
+// Ticks added to the host clock in place of simulation time
+static alt_64 skew = 0;
+
+alt_u64 hostPerfNow(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (alt_u64)ts.tv_sec * ALT_CPU_FREQ + (alt_u64)ts.tv_nsec * ALT_CPU_FREQ / 1000000000 + __atomic_load_n(&skew, __ATOMIC_RELAXED);
+}
+
+// Called from the SGDMA interrupt thread while the application reads the clock
+void hostPerfAdvance(alt_64 ticks)
+{
+	__atomic_add_fetch(&skew, ticks, __ATOMIC_RELAXED);
+}
+
+static int counting(int section)
+{
+	return sections[section].enabled && sections[0].enabled;
+}
+
+// Enable or disable a section at time t, time counted so far is settled first for every section whose counting can change
+static void setSection(int section, int enabled, alt_u64 t)
+{
+	if (sections[section].enabled == enabled) { return; }
+
+	int first = section;
+	int last  = section == 0 ? PERF_CNT_HOW_MANY_SECTIONS : section;
+
+	for (int i = first; i <= last; i++)
+	{
+		if (counting(i)) { sections[i].time += t - sections[i].start; }
+	}
+
+	// Starts are only counted while the global counter runs
+	if (enabled && (section == 0 || sections[0].enabled)) { sections[section].starts++; }
+	sections[section].enabled = enabled;
+
+	for (int i = first; i <= last; i++)
+	{
+		if (counting(i)) { sections[i].start = t; }
+	}
+}
+
+void hostPerfWrite(alt_u32 offset, alt_u32 data)
+{
+	int reg = offset / 4;
+	int section = reg / SECTION_REGS;
+	alt_u64 t = hostPerfNow();
+
+	if (section > PERF_CNT_HOW_MANY_SECTIONS) { return; }
+
+	if (reg % SECTION_REGS == BEGIN_REG)
+	{
+		setSection(section, 1, t);
+	}
+	else if (reg % SECTION_REGS == END_REG)
+	{
+		if (section == 0 && data == 1)
+		{
+			// Reset clears every section and stops the global counter
+			for (int i = 0; i <= PERF_CNT_HOW_MANY_SECTIONS; i++)
+			{
+				sections[i].time = 0;
+				sections[i].starts = 0;
+				sections[i].enabled = 0;
+			}
+		}
+		else
+		{
+			setSection(section, 0, t);
+		}
+	}
+}
+
+alt_u32 hostPerfRead(alt_u32 offset)
+{
+	int reg = offset / 4;
+	int section = reg / SECTION_REGS;
+
+	if (section > PERF_CNT_HOW_MANY_SECTIONS) { return 0; }
+
+	// A counting section reads its live value, like the RTL counters
+	alt_u64 time = sections[section].time;
+	if (counting(section)) { time += hostPerfNow() - sections[section].start; }
+
+	if (reg % SECTION_REGS == 0) { return (alt_u32)time; }
+	if (reg % SECTION_REGS == 1) { return (alt_u32)(time >> 32); }
+	if (reg % SECTION_REGS == 2) { return sections[section].starts; }
+	return 0;
+}
+
+// Like the HAL, reading stops the global counter so that the high and low words belong together
+alt_u64 perf_get_section_time(alt_u32 hw_base_address, int which_section)
+{
+	PERF_STOP_MEASURING(hw_base_address);
+	alt_u32 lo = IORD(hw_base_address, (which_section * SECTION_REGS));
+	alt_u32 hi = IORD(hw_base_address, (which_section * SECTION_REGS) + 1);
+	return ((alt_u64)hi << 32) | lo;
+}
+
+alt_u64 perf_get_total_time(alt_u32 hw_base_address)
+{
+	return perf_get_section_time(hw_base_address, 0);
+}
+
+alt_u32 perf_get_num_starts(alt_u32 hw_base_address, int which_section)
+{
+	return IORD(hw_base_address, (which_section * SECTION_REGS) + 2);
+}
+
+int perf_print_formatted_report(alt_u32 perf_base, alt_u32 clock_freq_hertz, int num_sections, ...)
+{
+	const char* separator     = "+---------------+-----+-----------+---------------+-----------+\n";
+	const char* column_header = "| Section       |  %  | Time (sec)|  Time (clocks)|Occurrences|\n";
+
+	va_list name_args;
+	va_start(name_args, num_sections);
+
+	alt_u64 total_clocks = perf_get_total_time(perf_base);
+	double total_sec = (double)total_clocks / clock_freq_hertz;
+
+	// Same layout as the BSP report so outputs can be compared directly
+	printf("--Performance Counter Report--\nTotal Time: %3G seconds  (%llu clock-cycles)\n%s%s%s", total_sec, (unsigned long long)total_clocks, separator, column_header, separator);
+
+	for (int section = 1; section <= num_sections; section++)
+	{
+		char* section_name = va_arg(name_args, char*);
+		alt_u64 section_clocks = perf_get_section_time(perf_base, section);
+
+		printf("|%-15s|%5.3g|%11.5f|%15llu|%11u|\n%s",
+		       section_name,
+		       total_clocks ? ((double)section_clocks * 100) / total_clocks : 0.0,
+		       (double)section_clocks / clock_freq_hertz,
+		       (unsigned long long)section_clocks,
+		       (unsigned int)perf_get_num_starts(perf_base, section),
+		       separator);
+	}
+
+	va_end(name_args);
+
+	return 0;
+}
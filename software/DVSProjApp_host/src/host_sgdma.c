@@ -0,0 +1,481 @@
+#include <altera_avalon_sgdma.h>
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <system.h>
+#include <sys/alt_irq.h>
+#include <altera_avalon_sgdma_regs.h>
+
+#include "host_hal.h"
+
+// Both controllers exist as in the system, m2s feeds acc_scale and s2m drains it
+static alt_sgdma_dev txDev = { SGDMA_M2S_NAME, SGDMA_M2S_BASE, NULL, NULL, 0, 0, 0, NULL };
+static alt_sgdma_dev rxDev = { SGDMA_S2M_NAME, SGDMA_S2M_BASE, NULL, NULL, 0, 0, 0, NULL };
+
+#define OWNED(desc) ((desc)->control & ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK)
+#define NEXT(desc) ((alt_sgdma_descriptor*)(void*)(desc)->next)
+
+// Descriptors are fetched and written back over a 32-bit port
+#define DESC_WORD 4
+#define DESC_WORDS (ALTERA_AVALON_SGDMA_DESCRIPTOR_SIZE / DESC_WORD)
+
+// Upper bound for configurable FIFO depth
+#define MAX_FIFO_DEPTH 4096
+
+// Engine states, a descriptor is fetched, its data transferred and its status written back
+#define STATE_FETCH 0
+#define STATE_DATA 1
+#define STATE_WRITEBACK 2
+#define STATE_DONE 3
+
+// Transaction types on the memory port
+#define TRANS_NONE 0
+#define TRANS_FETCH 1
+#define TRANS_DATA 2
+#define TRANS_WRITEBACK 3
+
+typedef struct
+{
+	alt_sgdma_dev* dev;
+	int write;                  // s2m writes data to memory, m2s reads it
+	int state;
+	alt_sgdma_descriptor* desc; // Descriptor being processed
+	int fetched;                // Descriptor words fetched so far
+	int issued;                 // Data bytes of descriptor requested from the port
+	int completed;              // Data bytes of descriptor finished by the port
+	alt_u8 fifo[MAX_FIFO_DEPTH];
+	int fifoHead;
+	int fifoCount;
+	int reserved;               // FIFO space claimed by reads in flight
+} SgdmaEngine;
+
+static HostSgdmaConfig config;
+static int configured = 0;
+static HostSgdmaStats stats;
+
+// Simulated transfer whose completion interrupt has not been raised yet, and when it is due on CLOCK_MONOTONIC
+// The interrupt thread raises it and runs the callbacks with interrupts disabled, so alt_irq_disable_all holds it off
+// Callbacks that start the next transfer simulate it on the interrupt thread and only schedule its completion
+static pthread_mutex_t pendingLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pendingChanged;
+static pthread_once_t interruptOnce = PTHREAD_ONCE_INIT;
+static int pending = 0;
+static int pendingError = 0;
+static struct timespec pendingDue;
+
+static int envInt(const char* name, int value)
+{
+	char* env = getenv(name);
+	return env != NULL ? atoi(env) : value;
+}
+
+HostSgdmaConfig* hostSgdmaConfig(void)
+{
+	if (!configured)
+	{
+		// Defaults are fitted to benchmark_4230065420.csv, 8-bit masters without bursts on the shared SDRAM port
+		config.clockFreq      = envInt("HOST_FABRIC_FREQ", 100000000);
+		config.readLatency    = envInt("HOST_SDRAM_READ_LATENCY", 13);
+		config.writeLatency   = envInt("HOST_SDRAM_WRITE_LATENCY", 8);
+		config.turnaround     = envInt("HOST_SDRAM_TURNAROUND", 5);
+		config.dataWidth      = envInt("HOST_SGDMA_DATA_WIDTH", 1);
+		config.burstLength    = envInt("HOST_SGDMA_BURST", 1);
+		config.fifoDepth      = envInt("HOST_SGDMA_FIFO_DEPTH", 64);
+		config.descOnchip     = envInt("HOST_SGDMA_DESC_ONCHIP", 0);
+		if (config.dataWidth < 1)                { config.dataWidth = 1; }
+		if (config.burstLength < 1)              { config.burstLength = 1; }
+		if (config.fifoDepth > MAX_FIFO_DEPTH)   { config.fifoDepth = MAX_FIFO_DEPTH; }
+		if (config.fifoDepth < config.dataWidth * config.burstLength) { config.fifoDepth = config.dataWidth * config.burstLength; }
+		configured = 1;
+	}
+	return &config;
+}
+
+HostSgdmaStats* hostSgdmaStats(void)
+{
+	return &stats;
+}
+
+static void constructDescriptor(alt_sgdma_descriptor* desc, alt_sgdma_descriptor* next, alt_u32* readAddr, alt_u32* writeAddr, alt_u16 length, int generateEop, int readFixed, int writeFixedOrSop, alt_u8 atlanticChannel)
+{
+	// Mark the next descriptor as not owned by hardware, so the chain ends there unless it is constructed later
+	next->control &= ~ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK;
+
+	// Next pointer is stored as a plain address, the controller does not care about alignment of the C type
+	uintptr_t nextAddr = (uintptr_t)next;
+
+	desc->read_addr                = readAddr;
+	desc->write_addr               = writeAddr;
+	desc->next                     = (alt_u32*)nextAddr;
+	desc->bytes_to_transfer        = length;
+	desc->read_burst               = 0;
+	desc->write_burst              = 0;
+	desc->actual_bytes_transferred = 0;
+	desc->status                   = 0;
+	desc->control                  = ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK
+	                               | (generateEop ? ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_GENERATE_EOP_MSK : 0)
+	                               | (readFixed ? ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_READ_FIXED_ADDRESS_MSK : 0)
+	                               | (writeFixedOrSop ? ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_WRITE_FIXED_ADDRESS_MSK : 0)
+	                               | (atlanticChannel ? ((atlanticChannel & 0x0F) << 3) : 0);
+}
+
+void alt_avalon_sgdma_construct_stream_to_mem_desc(alt_sgdma_descriptor* desc, alt_sgdma_descriptor* next, alt_u32* write_addr, alt_u16 length_or_eop, int write_fixed)
+{
+	constructDescriptor(desc, next, NULL, write_addr, length_or_eop, 0, 0, write_fixed, 0);
+}
+
+void alt_avalon_sgdma_construct_mem_to_stream_desc(alt_sgdma_descriptor* desc, alt_sgdma_descriptor* next, alt_u32* read_addr, alt_u16 length, int read_fixed, int generate_sop, int generate_eop, alt_u8 atlantic_channel)
+{
+	constructDescriptor(desc, next, read_addr, NULL, length, generate_eop, read_fixed, generate_sop, atlantic_channel);
+}
+
+// Finish the chain on a controller and raise its interrupt if enabled
+static void completeChain(alt_sgdma_dev* dev, int error)
+{
+	dev->status &= ~ALTERA_AVALON_SGDMA_STATUS_BUSY_MSK;
+	dev->status |= ALTERA_AVALON_SGDMA_STATUS_DESC_COMPLETED_MSK | ALTERA_AVALON_SGDMA_STATUS_CHAIN_COMPLETED_MSK;
+	if (error) { dev->status |= ALTERA_AVALON_SGDMA_STATUS_ERROR_MSK; }
+
+	alt_u32 irqMask = ALTERA_AVALON_SGDMA_CONTROL_IE_GLOBAL_MSK | ALTERA_AVALON_SGDMA_CONTROL_IE_CHAIN_COMPLETED_MSK;
+	if (dev->callback != NULL && (dev->control & irqMask) == irqMask) { dev->callback(dev->callback_context); }
+}
+
+static void initEngine(SgdmaEngine* engine, alt_sgdma_dev* dev, int write)
+{
+	engine->dev       = dev;
+	engine->write     = write;
+	engine->state     = STATE_FETCH;
+	engine->desc      = dev->chain;
+	engine->fetched   = 0;
+	engine->fifoHead  = 0;
+	engine->fifoCount = 0;
+	engine->reserved  = 0;
+}
+
+static void fifoPush(SgdmaEngine* engine, alt_u8 data)
+{
+	engine->fifo[(engine->fifoHead + engine->fifoCount) % config.fifoDepth] = data;
+	engine->fifoCount++;
+}
+
+static alt_u8 fifoPop(SgdmaEngine* engine)
+{
+	alt_u8 data = engine->fifo[engine->fifoHead];
+	engine->fifoHead = (engine->fifoHead + 1) % config.fifoDepth;
+	engine->fifoCount--;
+	return data;
+}
+
+// Size of the next data transaction, one burst or whatever is left of the descriptor
+static int chunkSize(SgdmaEngine* engine)
+{
+	int remaining = engine->desc->bytes_to_transfer - engine->issued;
+	int burst = config.dataWidth * config.burstLength;
+	return remaining < burst ? remaining : burst;
+}
+
+// Returns the transaction type the engine wants to issue this cycle, and its size in bytes
+static int engineRequest(SgdmaEngine* engine, int* bytes)
+{
+	if (engine->state == STATE_FETCH)     { *bytes = DESC_WORD; return TRANS_FETCH; }
+	if (engine->state == STATE_WRITEBACK) { *bytes = DESC_WORD; return TRANS_WRITEBACK; }
+	if (engine->state != STATE_DATA)      { return TRANS_NONE; }
+
+	int chunk = chunkSize(engine);
+	if (chunk == 0) { return TRANS_NONE; }
+
+	// Reads need room in the FIFO for the data they bring, writes need the data already in the FIFO
+	if (!engine->write && engine->fifoCount + engine->reserved + chunk > config.fifoDepth) { return TRANS_NONE; }
+	if (engine->write && engine->fifoCount < chunk) { return TRANS_NONE; }
+
+	*bytes = chunk;
+	return TRANS_DATA;
+}
+
+// Descriptor data has been read into the controller
+static void fetchDone(SgdmaEngine* engine)
+{
+	if (++engine->fetched < DESC_WORDS) { return; }
+	engine->fetched = 0;
+	stats.descriptors++;
+
+	// Descriptor not owned by hardware ends the chain
+	if (!OWNED(engine->desc))
+	{
+		engine->state = STATE_DONE;
+		return;
+	}
+
+	engine->issued    = 0;
+	engine->completed = 0;
+	engine->state     = engine->desc->bytes_to_transfer ? STATE_DATA : STATE_WRITEBACK;
+}
+
+static void dataDone(SgdmaEngine* engine, int offset, int bytes)
+{
+	alt_u8* memory = (alt_u8*)(engine->write ? engine->desc->write_addr : engine->desc->read_addr);
+
+	if (engine->write)
+	{
+		stats.bytesWritten += bytes;
+	}
+	else
+	{
+		// Data arrives into space reserved when the read was issued
+		for (int i = 0; i < bytes; i++) { fifoPush(engine, memory[offset + i]); }
+		engine->reserved -= bytes;
+		stats.bytesRead += bytes;
+	}
+
+	engine->completed += bytes;
+	if (engine->completed == engine->desc->bytes_to_transfer) { engine->state = STATE_WRITEBACK; }
+}
+
+static void writebackDone(SgdmaEngine* engine)
+{
+	engine->desc->actual_bytes_transferred = engine->completed;
+	engine->desc->status = 0;
+	engine->desc->control &= ~ALTERA_AVALON_SGDMA_DESCRIPTOR_CONTROL_OWNED_BY_HW_MSK;
+	engine->desc = NEXT(engine->desc);
+	engine->state = STATE_FETCH;
+}
+
+// Interrupt thread standing in for the SGDMA interrupts at the end of a transfer, data has already been moved by the simulation
+static void* interruptMain(void* arg)
+{
+	pthread_mutex_lock(&pendingLock);
+	while (1)
+	{
+		if (!pending) { pthread_cond_wait(&pendingChanged, &pendingLock); continue; }
+		if (pthread_cond_timedwait(&pendingChanged, &pendingLock, &pendingDue) != ETIMEDOUT) { continue; }
+		if (!pending) { continue; }
+
+		int error = pendingError;
+		pending = 0;
+		pthread_mutex_unlock(&pendingLock);
+
+		alt_irq_context irq = alt_irq_disable_all();
+		completeChain(&txDev, error);
+		completeChain(&rxDev, error);
+		alt_irq_enable_all(irq);
+
+		pthread_mutex_lock(&pendingLock);
+	}
+	return NULL;
+}
+
+static void interruptInit(void)
+{
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&pendingChanged, &attr);
+	pthread_condattr_destroy(&attr);
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, interruptMain, NULL) != 0) { fprintf(stderr, "SGDMA model: failed to start interrupt thread\n"); exit(1); }
+	pthread_detach(thread);
+}
+
+// Raise the completion interrupts once the given number of nanoseconds has passed
+static void scheduleCompletion(alt_64 nsec, int error)
+{
+	pthread_once(&interruptOnce, interruptInit);
+
+	struct timespec due;
+	clock_gettime(CLOCK_MONOTONIC, &due);
+	if (nsec > 0)
+	{
+		due.tv_sec  += nsec / 1000000000;
+		due.tv_nsec += nsec % 1000000000;
+		if (due.tv_nsec >= 1000000000) { due.tv_sec++; due.tv_nsec -= 1000000000; }
+	}
+
+	pthread_mutex_lock(&pendingLock);
+	pending = 1;
+	pendingError = error;
+	pendingDue = due;
+	pthread_cond_signal(&pendingChanged);
+	pthread_mutex_unlock(&pendingLock);
+}
+
+// Once both controllers are running, stream the tx chain through acc_scale into the rx chain cycle by cycle
+// The shared SDRAM port serves one transaction at a time and the two masters take turns
+static void runTransfer()
+{
+	int busy = ALTERA_AVALON_SGDMA_STATUS_BUSY_MSK;
+	if (!(txDev.status & busy) || !(rxDev.status & busy)) { return; }
+
+	hostSgdmaConfig();
+	memset(&stats, 0, sizeof(HostSgdmaStats));
+
+	static SgdmaEngine engines[2];
+	SgdmaEngine* tx = &engines[0];
+	SgdmaEngine* rx = &engines[1];
+	initEngine(tx, &txDev, 0);
+	initEngine(rx, &rxDev, 1);
+
+	AccScaleModel* acc = hostAccScaleModel();
+
+	SgdmaEngine* owner = NULL;
+	int transType = TRANS_NONE;
+	int transOffset = 0;
+	int transBytes = 0;
+	int portCycles = 0;
+	int lastWrite = 0;
+	int turn = 0;
+	int stalled = 0;
+
+	alt_u64 wallStart = hostPerfNow();
+
+	while (tx->state != STATE_DONE || rx->state != STATE_DONE)
+	{
+		int progress = 0;
+
+		// Finish transaction on the port
+		if (owner != NULL && --portCycles == 0)
+		{
+			if (transType == TRANS_FETCH)          { fetchDone(owner); }
+			else if (transType == TRANS_DATA)      { dataDone(owner, transOffset, transBytes); }
+			else if (transType == TRANS_WRITEBACK) { writebackDone(owner); }
+			owner = NULL;
+			progress = 1;
+		}
+
+		// Descriptors in on-chip memory are fetched and written back over a port of their own, one word per cycle
+		for (int i = 0; config.descOnchip && i < 2; i++)
+		{
+			int bytes = 0;
+			int type = engineRequest(&engines[i], &bytes);
+			if (type == TRANS_FETCH)          { fetchDone(&engines[i]); progress = 1; }
+			else if (type == TRANS_WRITEBACK) { writebackDone(&engines[i]); progress = 1; }
+		}
+
+		// Arbitrate free port between the two masters in round robin order
+		for (int i = 0; owner == NULL && i < 2; i++)
+		{
+			SgdmaEngine* engine = &engines[(turn + i) % 2];
+			int bytes = 0;
+			int type = engineRequest(engine, &bytes);
+			if (type == TRANS_NONE || (config.descOnchip && type != TRANS_DATA)) { continue; }
+
+			int write = type == TRANS_WRITEBACK || (type == TRANS_DATA && engine->write);
+			int beats = (bytes + config.dataWidth - 1) / config.dataWidth;
+			portCycles = (write ? config.writeLatency : config.readLatency) + (beats - 1);
+			if (write != lastWrite) { portCycles += config.turnaround; stats.turnarounds++; }
+			if (portCycles < 1) { portCycles = 1; }
+
+			owner = engine;
+			transType = type;
+			transBytes = bytes;
+			lastWrite = write;
+			turn = (turn + i + 1) % 2;
+			stats.transactions++;
+
+			if (type == TRANS_DATA)
+			{
+				// Claim the data or FIFO space immediately so later requests see it taken
+				transOffset = engine->issued;
+				engine->issued += bytes;
+				alt_u8* memory = (alt_u8*)engine->desc->write_addr;
+				if (engine->write) { for (int j = 0; j < bytes; j++) { memory[transOffset + j] = fifoPop(engine); } }
+				else               { engine->reserved += bytes; }
+			}
+			progress = 1;
+		}
+		if (owner != NULL) { stats.portBusy++; }
+
+		// Move one pixel on each stream
+		int asiValid = tx->fifoCount > 0;
+		int asoReady = rx->fifoCount < config.fifoDepth && rx->state != STATE_DONE;
+		int asiReady = accModelAsiReady(acc);
+		int asoValid = accModelAsoValid(acc);
+		alt_u8 data  = accModelAsoData(acc);
+
+		if (accModelClock(acc, asiValid, asiValid ? tx->fifo[tx->fifoHead] : 0, asoReady))
+		{
+			if (asiValid && asiReady) { fifoPop(tx); }
+			if (asoValid && asoReady) { fifoPush(rx, data); }
+			progress = 1;
+		}
+
+		stats.cycles++;
+
+		// Nothing can change anymore, real hardware would hang here waiting for data
+		if (!progress && owner == NULL)
+		{
+			if (++stalled > 1) { break; }
+		}
+		else
+		{
+			stalled = 0;
+		}
+	}
+
+	// Hide time spent simulating from the performance counter, the transfer takes modelled time from the moment it started
+	hostPerfAdvance(-(alt_64)(hostPerfNow() - wallStart));
+	alt_64 remaining = (alt_64)(stats.cycles * ((double)ALT_CPU_FREQ / config.clockFreq));
+
+	int error = tx->state != STATE_DONE || rx->state != STATE_DONE;
+	if (error) { fprintf(stderr, "SGDMA model: transfer stalled after %llu cycles\n", (unsigned long long)stats.cycles); }
+
+	// Raise the completion interrupts once modelled time has passed, the CPU is free to run in the meantime like on the board
+	scheduleCompletion((alt_64)(remaining * (1e9 / ALT_CPU_FREQ)), error);
+}
+
+int alt_avalon_sgdma_do_async_transfer(alt_sgdma_dev* dev, alt_sgdma_descriptor* desc)
+{
+	// Return with error immediately if controller is busy
+	if (dev->status & ALTERA_AVALON_SGDMA_STATUS_BUSY_MSK) { return -EBUSY; }
+
+	// Point the controller at the descriptor and run, enabling interrupts only if a callback is registered
+	dev->chain = desc;
+	dev->status = ALTERA_AVALON_SGDMA_STATUS_BUSY_MSK;
+	dev->control |= ALTERA_AVALON_SGDMA_CONTROL_RUN_MSK | ALTERA_AVALON_SGDMA_CONTROL_STOP_DMA_ER_MSK;
+	if (dev->callback != NULL) { dev->control |= dev->chain_control; }
+	else                       { dev->control &= ~ALTERA_AVALON_SGDMA_CONTROL_IE_GLOBAL_MSK; }
+
+	runTransfer();
+
+	return 0;
+}
+
+void alt_avalon_sgdma_register_callback(alt_sgdma_dev* dev, alt_avalon_sgdma_callback callback, alt_u32 chain_control, void* context)
+{
+	dev->callback         = callback;
+	dev->callback_context = context;
+	dev->chain_control    = chain_control;
+}
+
+// A controller stopped before its chain could run, like tx when rx fails to start, goes idle right away
+// Chains already simulated still complete from the interrupt thread
+void alt_avalon_sgdma_stop(alt_sgdma_dev* dev)
+{
+	dev->control &= ~ALTERA_AVALON_SGDMA_CONTROL_RUN_MSK;
+
+	pthread_mutex_lock(&pendingLock);
+	if (!pending) { dev->status &= ~ALTERA_AVALON_SGDMA_STATUS_BUSY_MSK; }
+	pthread_mutex_unlock(&pendingLock);
+}
+
+alt_sgdma_dev* alt_avalon_sgdma_open(const char* name)
+{
+	if (strcmp(name, txDev.name) == 0) { return &txDev; }
+	if (strcmp(name, rxDev.name) == 0) { return &rxDev; }
+	return NULL;
+}
+
+void hostSgdmaPrintStats(FILE* f)
+{
+	fprintf(f, "--SGDMA Model Report--\n");
+	fprintf(f, "Memory:         read %d, write %d, turnaround %d cycles, %d byte beats, %d beat bursts, %d byte FIFOs\n", config.readLatency, config.writeLatency, config.turnaround, config.dataWidth, config.burstLength, config.fifoDepth);
+	fprintf(f, "Cycles:         %llu (%.6f s at %d Hz)\n", (unsigned long long)stats.cycles, (double)stats.cycles / config.clockFreq, config.clockFreq);
+	fprintf(f, "Descriptors:    %llu fetched\n", (unsigned long long)stats.descriptors);
+	fprintf(f, "Transactions:   %llu (%llu turnarounds)\n", (unsigned long long)stats.transactions, (unsigned long long)stats.turnarounds);
+	fprintf(f, "Data:           %llu bytes read, %llu bytes written\n", (unsigned long long)stats.bytesRead, (unsigned long long)stats.bytesWritten);
+	fprintf(f, "Port busy:      %llu cycles (%.1f%%)\n", (unsigned long long)stats.portBusy, stats.cycles ? 100.0 * stats.portBusy / stats.cycles : 0.0);
+}
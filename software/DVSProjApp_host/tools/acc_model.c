@@ -0,0 +1,71 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sw_impl.h"
+#include "hw_impl.h"
+#include "host_hal.h"
+
+// Predicts acc_scale throughput for a frame by running the driver against the cycle-accurate model
+// Memory timing is taken from the HOST_SDRAM_* and HOST_SGDMA_* environment variables, see host_hal.h
+// Usage: acc_model <width> <height> <xScale> [yScale] [hscd]
+
+void printUsage()
+{
+	printf("Usage: acc_model <width> <height> <xScale> [yScale] [hscd]\n");
+	printf("Scale factors are in range {-4, -3, -2, -1, 1, 2, 3, 4}, hscd runs scaleHSCD instead of scaleHW\n");
+}
+
+int main(int argc, char** argv)
+{
+	HWContext context;
+	HWContext* ctx = &context;
+
+	if (argc < 4) { printUsage(); return 1; }
+
+	int width  = atoi(argv[1]);
+	int height = atoi(argv[2]);
+	int xScale = atoi(argv[3]);
+	int yScale = argc > 4 && strcmp(argv[4], "hscd") != 0 ? atoi(argv[4]) : xScale;
+	int hscd   = strcmp(argv[argc - 1], "hscd") == 0;
+
+	if (width <= 0 || height <= 0 || xScale == 0 || xScale < -4 || xScale > 4 || yScale == 0 || yScale < -4 || yScale > 4) { printUsage(); return 1; }
+
+	// Calculate destination image dimensions
+	int destinationWidth  = xScale > 0 ? width  * xScale : (width  - xScale - 1) / -xScale;
+	int destinationHeight = yScale > 0 ? height * yScale : (height - yScale - 1) / -yScale;
+
+	unsigned char* source           = malloc(width * height);
+	unsigned char* referenceImage   = malloc(destinationWidth * destinationHeight);
+	unsigned char* destinationImage = malloc(destinationWidth * destinationHeight);
+	if (source == NULL || referenceImage == NULL || destinationImage == NULL) { printf("Failed to allocate buffers\n"); return 1; }
+
+	// Pseudo random image so that misplaced pixels show up in the comparison
+	srand(width * height);
+	for (int i = 0; i < width * height; i++) { source[i] = rand(); }
+
+	initHW(ctx);
+	if (checkHW(ctx)) { return 1; }
+
+	scaleSW(source, referenceImage, width, height, 0, 0, width, height, destinationWidth, destinationHeight, xScale, yScale);
+
+	if (hscd) { scaleHSCD(ctx, source, destinationImage, width, height, 0, 0, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+	else      { scaleHW  (ctx, source, destinationImage, width, height, 0, 0, width, height, destinationWidth, destinationHeight, xScale, yScale); }
+	if (checkHW(ctx)) { return 1; }
+
+	AccScaleModel* model = hostAccScaleModel();
+	hostSgdmaPrintStats(stdout);
+	accModelPrintStats(model, stdout);
+
+	// One pixel per clock on the busier side of the accelerator is the best the pipeline can do
+	alt_u64 ideal = model->stats.inputPixels > model->stats.outputPixels ? model->stats.inputPixels : model->stats.outputPixels;
+	printf("Ideal cycles:   %llu (%.1f%% efficiency)\n", (unsigned long long)ideal, model->stats.cycles ? 100.0 * ideal / model->stats.cycles : 0.0);
+	printf("Result:         %s\n", memcmp(referenceImage, destinationImage, destinationWidth * destinationHeight) == 0 ? "OK" : "ERR");
+
+	cleanupHW(ctx);
+	free(source);
+	free(referenceImage);
+	free(destinationImage);
+
+	return 0;
+}
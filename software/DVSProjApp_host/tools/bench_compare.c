@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Compares a benchmark CSV against a baseline CSV and fails when the new run is slower
+// Cases are matched by x, y, w, h, xScale and yScale, each implementation is compared by the median of its verified repeats
+// Usage: bench_compare <baseline.csv> <new.csv> [threshold]
+
+#define MAX_CASES 4096
+#define MAX_REPEATS 256
+#define MAX_LINE (16 * 1024)
+#define PATHS 3
+
+// Relative slowdown reported as a regression by default
+#define THRESHOLD 0.05
+// Differences below the resolution of the CSV times are never reported
+#define MIN_DIFFERENCE 0.000002
+
+static const char* pathNames[PATHS] = { "SW", "HW", "HSCD" };
+
+typedef struct
+{
+	int key[6];
+	// Median time of the verified repeats of each path, negative when none passed verification
+	double median[PATHS];
+	int failed[PATHS];
+} Result;
+
+void printUsage()
+{
+	printf("Usage: bench_compare <baseline.csv> <new.csv> [threshold]\n");
+	printf("threshold is the relative slowdown reported as a regression, %.2f by default\n", THRESHOLD);
+	printf("Exits with 2 when any case or the total of any implementation regressed or failed verification\n");
+}
+
+int compareDoubles(const void* a, const void* b)
+{
+	double da = *(const double*)a;
+	double db = *(const double*)b;
+	return (da > db) - (da < db);
+}
+
+// Reads a benchmark CSV, each line holds x, y, w, h, xScale and yScale, then SW, HW and HSCD times of every repeat and their error counts
+// The repeat count is taken from the number of fields, so runs with different repeat counts can be compared
+int loadResults(char* fname, Result* results, int* count)
+{
+	FILE* f = fopen(fname, "r");
+	if (f == NULL) { printf("Failed to open %s\n", fname); return 1; }
+
+	static char line[MAX_LINE];
+	*count = 0;
+	while (fgets(line, MAX_LINE, f) != NULL)
+	{
+		if (line[0] == '\n' || line[0] == '\r' || line[0] == 0) { continue; }
+		if (*count >= MAX_CASES) { printf("Too many cases in %s\n", fname); fclose(f); return 1; }
+
+		double fields[6 + 2 * PATHS * MAX_REPEATS];
+		int n = 0;
+		char* next = line;
+		while (n < 6 + 2 * PATHS * MAX_REPEATS)
+		{
+			char* end;
+			fields[n] = strtod(next, &end);
+			if (end == next) { break; }
+			n++;
+			if (*end != ',') { break; }
+			next = end + 1;
+		}
+
+		int repeats = (n - 6) / (2 * PATHS);
+		if (repeats < 1 || n != 6 + 2 * PATHS * repeats) { printf("Malformed line %d in %s\n", *count + 1, fname); fclose(f); return 1; }
+
+		Result* r = &results[(*count)++];
+		for (int i = 0; i < 6; i++) { r->key[i] = (int)fields[i]; }
+
+		double* times = &fields[6];
+		double* errors = &fields[6 + PATHS * repeats];
+		for (int p = 0; p < PATHS; p++)
+		{
+			double sorted[MAX_REPEATS];
+			int valid = 0;
+			for (int j = 0; j < repeats; j++)
+			{
+				if (errors[j * PATHS + p] == 0) { sorted[valid++] = times[j * PATHS + p]; }
+			}
+			qsort(sorted, valid, sizeof(double), compareDoubles);
+
+			r->failed[p] = repeats - valid;
+			if (valid == 0)          { r->median[p] = -1; }
+			else if (valid % 2 == 1) { r->median[p] = sorted[valid / 2]; }
+			else                     { r->median[p] = (sorted[valid / 2 - 1] + sorted[valid / 2]) / 2; }
+		}
+	}
+
+	fclose(f);
+	return 0;
+}
+
+Result* findResult(Result* results, int count, int* key)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (memcmp(results[i].key, key, sizeof(results[i].key)) == 0) { return &results[i]; }
+	}
+	return NULL;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) { printUsage(); return 1; }
+
+	double threshold = argc > 3 ? atof(argv[3]) : THRESHOLD;
+	if (threshold < 0) { printUsage(); return 1; }
+
+	static Result baseline[MAX_CASES];
+	static Result current[MAX_CASES];
+	int baselineCount;
+	int currentCount;
+	if (loadResults(argv[1], baseline, &baselineCount)) { return 1; }
+	if (loadResults(argv[2], current, &currentCount)) { return 1; }
+
+	// Per case comparison, totals only include cases where both runs have a verified time
+	double baselineTotal[PATHS] = {0};
+	double currentTotal[PATHS] = {0};
+	int regressions = 0;
+	int failures = 0;
+	int matched = 0;
+	for (int i = 0; i < currentCount; i++)
+	{
+		Result* c = &current[i];
+		Result* b = findResult(baseline, baselineCount, c->key);
+		if (b == NULL) { continue; }
+		matched++;
+
+		for (int p = 0; p < PATHS; p++)
+		{
+			if (c->failed[p] > b->failed[p])
+			{
+				printf("FAIL %d,%d,%d,%d,%d,%d %-4s %d failed runs, baseline %d\n", c->key[0], c->key[1], c->key[2], c->key[3], c->key[4], c->key[5], pathNames[p], c->failed[p], b->failed[p]);
+				failures++;
+			}
+			if (c->median[p] < 0 || b->median[p] < 0) { continue; }
+
+			baselineTotal[p] += b->median[p];
+			currentTotal[p] += c->median[p];
+
+			double slowdown = b->median[p] > 0 ? c->median[p] / b->median[p] - 1 : 0;
+			if (slowdown > threshold && c->median[p] - b->median[p] > MIN_DIFFERENCE)
+			{
+				printf("SLOW %d,%d,%d,%d,%d,%d %-4s %f s against %f s, %+.1f%%\n", c->key[0], c->key[1], c->key[2], c->key[3], c->key[4], c->key[5], pathNames[p], c->median[p], b->median[p], slowdown * 100);
+				regressions++;
+			}
+		}
+	}
+
+	if (matched == 0) { printf("No cases of %s match %s\n", argv[2], argv[1]); return 1; }
+
+	printf("Matched %d of %d cases, baseline has %d\n", matched, currentCount, baselineCount);
+
+	for (int p = 0; p < PATHS; p++)
+	{
+		double slowdown = baselineTotal[p] > 0 ? currentTotal[p] / baselineTotal[p] - 1 : 0;
+		int slow = slowdown > threshold && currentTotal[p] - baselineTotal[p] > MIN_DIFFERENCE;
+		printf("%-4s total %f s against %f s, %+.1f%%%s\n", pathNames[p], currentTotal[p], baselineTotal[p], slowdown * 100, slow ? ", regression" : "");
+		regressions += slow;
+	}
+
+	printf("%d regressions beyond %.1f%%, %d verification failures\n", regressions, threshold * 100, failures);
+
+	return regressions > 0 || failures > 0 ? 2 : 0;
+}
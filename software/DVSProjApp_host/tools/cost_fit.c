@@ -0,0 +1,103 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "auto_impl.h"
+
+// Fits the scaleAuto cost model to a benchmark CSV and writes it to a model file
+// Reports how far predictions are from the measurements and how often the fastest path is chosen
+// Usage: cost_fit <benchmark.csv> <model> [repeats]
+
+#define MAX_SAMPLES 16384
+#define MAX_REPEATS 256
+#define REPEATS 3
+
+static const char* pathNames[AUTO_PATHS] = { "SW", "HW", "HSCD" };
+
+void printUsage()
+{
+	printf("Usage: cost_fit <benchmark.csv> <model> [repeats]\n");
+	printf("repeats is the repeat count the benchmark ran with, 3 by default\n");
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 3) { printUsage(); return 1; }
+
+	int repeats = argc > 3 ? atoi(argv[3]) : REPEATS;
+	if (repeats < 1 || repeats > MAX_REPEATS) { printUsage(); return 1; }
+
+	FILE* f = fopen(argv[1], "r");
+	if (f == NULL) { printf("Failed to open %s\n", argv[1]); return 1; }
+
+	static CostSample samples[MAX_SAMPLES];
+	int count = 0;
+
+	// Each line holds x, y, w, h, xScale and yScale, then SW, HW and HSCD times of every repeat and their error counts
+	int x, y, w, h, xScale, yScale;
+	while (count + repeats <= MAX_SAMPLES && fscanf(f, "%d,%d,%d,%d,%d,%d", &x, &y, &w, &h, &xScale, &yScale) == 6)
+	{
+		static double times[AUTO_PATHS * MAX_REPEATS];
+		static int errors[AUTO_PATHS * MAX_REPEATS];
+		for (int i = 0; i < AUTO_PATHS * repeats; i++) { if (fscanf(f, ",%lf", &times[i]) != 1) { printf("Malformed line\n"); return 1; } }
+		for (int i = 0; i < AUTO_PATHS * repeats; i++) { if (fscanf(f, ",%d", &errors[i]) != 1) { printf("Malformed line\n"); return 1; } }
+
+		for (int r = 0; r < repeats; r++)
+		{
+			CostSample* s = &samples[count++];
+			s->width             = w;
+			s->height            = h;
+			s->destinationWidth  = xScale > 0 ? w * xScale : (w - xScale - 1) / -xScale;
+			s->destinationHeight = yScale > 0 ? h * yScale : (h - yScale - 1) / -yScale;
+			// Benchmark images are aligned and their lines padded to whole words, so only x and the destination width move lines off a word
+			s->misaligned        = ((x | s->destinationWidth) & 3) != 0;
+			s->xScale            = xScale;
+			s->yScale            = yScale;
+			for (int p = 0; p < AUTO_PATHS; p++) { s->time[p] = errors[r * AUTO_PATHS + p] == 0 ? times[r * AUTO_PATHS + p] : -1; }
+		}
+	}
+	fclose(f);
+
+	if (count == 0) { printf("No measurements in %s\n", argv[1]); return 1; }
+
+	CostModel model = {0};
+	fitCostModel(&model, samples, count);
+	setCostModel(&model);
+
+	// Fit quality, relative error of every path and time lost by picking the predicted fastest path
+	double relative[AUTO_PATHS] = {0};
+	double worst[AUTO_PATHS] = {0};
+	double chosenTime = 0;
+	double bestTime = 0;
+	int hits = 0;
+	for (int i = 0; i < count; i++)
+	{
+		CostSample* s = &samples[i];
+		int best = 0;
+		int chosen = 0;
+		float chosenCost = -1;
+		for (int p = 0; p < AUTO_PATHS; p++)
+		{
+			float cost = predictCost(p, s->misaligned, s->width, s->height, s->destinationWidth, s->destinationHeight, s->xScale, s->yScale);
+			double error = (cost - s->time[p]) / s->time[p];
+			if (error < 0) { error = -error; }
+			relative[p] += error;
+			if (error > worst[p]) { worst[p] = error; }
+			if (s->time[p] < s->time[best]) { best = p; }
+			if (chosenCost < 0 || cost < chosenCost) { chosen = p; chosenCost = cost; }
+		}
+		hits += chosen == best;
+		chosenTime += s->time[chosen];
+		bestTime += s->time[best];
+	}
+
+	for (int p = 0; p < AUTO_PATHS; p++)
+	{
+		printf("%-4s mean relative error %.3f, worst %.3f\n", pathNames[p], relative[p] / count, worst[p]);
+	}
+	printf("Fastest path chosen for %d of %d measurements, %.6fs total against %.6fs best\n", hits, count, chosenTime, bestTime);
+
+	if (saveCostModel(&model, argv[2])) { printf("Failed to write %s\n", argv[2]); return 1; }
+	printf("Model written to %s\n", argv[2]);
+
+	return 0;
+}
@@ -0,0 +1,123 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sw_impl.h"
+#include "hw_impl.h"
+
+// Checks scaleHWInto and scaleHSCDInto against scaleSW for every scale factor pair on the SGDMA and acc_scale models
+// Regions are written into larger destination images, every pixel outside the region must keep the guard value
+// Usage: into_check
+
+// Synthesized source, wider than the accelerator line buffer
+#define SOURCE_WIDTH 1536
+#define SOURCE_HEIGHT 64
+#define CASES 4
+#define GUARD_BYTE 0xA5
+#define MAX_ERRORS 10
+
+// Region of one check and where it goes in the destination image
+// Destination lines are destinationX + destination width + padding apart, the image has two more lines below the region
+typedef struct
+{
+	int x;
+	int y;
+	int w;
+	int h;
+	int destinationX;
+	int destinationY;
+	int padding;
+} IntoCase;
+
+// A region inside an image with wider lines, destination lines that directly follow each other so rx descriptors are coalesced,
+// coalesced runs longer than one descriptor, and a region wider than the line buffer that is split into tiles
+static IntoCase cases[CASES] = {
+	{   5,  3,  301, 37, 13, 2, 19 },
+	{   0,  1,  256,  9,  0, 1,  0 },
+	{   0,  0,  512, 40,  0, 0,  0 },
+	{ 117, 20, 1300,  8,  7, 3, 25 },
+};
+
+static const int validScales[] = {-4, -3, -2, -1, 1, 2, 3, 4};
+
+static int errors = 0;
+
+static int scaledSize(int size, int scale)
+{
+	return scale > 0 ? size * scale : (size - scale - 1) / -scale;
+}
+
+// Returns the number of wrong pixels, or -1 after a hardware error
+static int checkInto(HWContext* ctx, int hscd, IntoCase* c, int xScale, int yScale, unsigned char* source, unsigned char* reference, unsigned char* destination)
+{
+	int destinationWidth  = scaledSize(c->w, xScale);
+	int destinationHeight = scaledSize(c->h, yScale);
+	int destinationStride = c->destinationX + destinationWidth + c->padding;
+	int imageHeight       = c->destinationY + destinationHeight + 2;
+
+	scaleSW(source, reference, SOURCE_WIDTH, SOURCE_HEIGHT, c->x, c->y, c->w, c->h, destinationWidth, destinationHeight, xScale, yScale);
+
+	memset(destination, GUARD_BYTE, destinationStride * imageHeight);
+	if (hscd) { scaleHSCDInto(ctx, source, destination, SOURCE_WIDTH, SOURCE_HEIGHT, c->x, c->y, c->w, c->h, c->destinationX, c->destinationY, destinationStride, xScale, yScale); }
+	else      { scaleHWInto(ctx, source, destination, SOURCE_WIDTH, SOURCE_HEIGHT, c->x, c->y, c->w, c->h, c->destinationX, c->destinationY, destinationStride, xScale, yScale); }
+	if (checkHW(ctx)) { initHW(ctx); return -1; }
+
+	int res = 0;
+	for (int i = 0; i < imageHeight; i++)
+	{
+		for (int j = 0; j < destinationStride; j++)
+		{
+			int inside = i >= c->destinationY && i < c->destinationY + destinationHeight && j >= c->destinationX && j < c->destinationX + destinationWidth;
+			unsigned char expected = inside ? reference[(j - c->destinationX) + (i - c->destinationY) * destinationWidth] : GUARD_BYTE;
+			res += destination[j + i * destinationStride] != expected;
+		}
+	}
+	return res;
+}
+
+int main(int argc, char** argv)
+{
+	HWContext context;
+	HWContext* ctx = &context;
+
+	initHW(ctx);
+	if (checkHW(ctx)) { return 1; }
+
+	// Largest destination image of any case, the widest region at 4 x upscaling and the most lines of any region
+	int destinationSize = (4 * 1300 + 13 + 25) * (4 * 40 + 3 + 2);
+	unsigned char* source      = malloc(SOURCE_WIDTH * SOURCE_HEIGHT);
+	unsigned char* reference   = malloc(destinationSize);
+	unsigned char* destination = malloc(destinationSize);
+	if (source == NULL || reference == NULL || destination == NULL) { printf("Failed to allocate buffers\n"); return 1; }
+
+	srand(1);
+	for (int i = 0; i < SOURCE_WIDTH * SOURCE_HEIGHT; i++) { source[i] = rand(); }
+
+	printf("Checking scaling into a larger image\n");
+
+	for (int i = 0; i < CASES; i++)
+	{
+		for (int xi = 0; xi < 8; xi++)
+		{
+			for (int yi = 0; yi < 8; yi++)
+			{
+				for (int hscd = 0; hscd < 2; hscd++)
+				{
+					IntoCase* c = &cases[i];
+					int res = checkInto(ctx, hscd, c, validScales[xi], validScales[yi], source, reference, destination);
+					if (res == 0) { continue; }
+					if (errors++ < MAX_ERRORS) { printf("%s into %d %d %d %d %d %d: %s\n", hscd ? "HSCD" : "HW", c->x, c->y, c->w, c->h, validScales[xi], validScales[yi], res < 0 ? "hardware error" : "differs"); }
+				}
+			}
+		}
+	}
+
+	free(source);
+	free(reference);
+	free(destination);
+	cleanupHW(ctx);
+
+	if (errors > 0) { printf("%d of %d checks failed\n", errors, CASES * 8 * 8 * 2); return 1; }
+	printf("All checks passed\n");
+	return 0;
+}
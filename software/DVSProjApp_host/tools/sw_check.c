@@ -0,0 +1,150 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sw_impl.h"
+#include "sw_simd.h"
+
+// Checks the vector, word parallel and specialized frame kernels of scaleSW against byte at a time scaling
+// Every scale factor and factor pair is run over short widths at every source alignment a vector or word load can see
+// HOST_SW_SIMD selects the vector kernels under test, make check runs this once for every level
+// Usage: sw_check
+
+#define MAX_WIDTH 64
+// Lines up to this width are checked as well, so that the widest vector blocks are covered a few times
+#define MAX_LONG_WIDTH 320
+#define ALIGNMENTS 32
+#define GUARD 64
+#define GUARD_BYTE 0xA5
+#define MAX_ERRORS 10
+
+// Macro to calculate index in row linearized matrix from coordinates
+#define PIXEL(x, y, width) ((x) + (y) * (width))
+
+static const int validScales[] = {-4, -3, -2, -1, 1, 2, 3, 4};
+
+static int errors = 0;
+
+static int scaledSize(int size, int scale)
+{
+	return scale > 0 ? size * scale : (size - scale - 1) / -scale;
+}
+
+static void fail(const char* what, int xScale, int yScale, int width, int height, int alignment)
+{
+	if (errors++ < MAX_ERRORS) { printf("%s differs: xScale %d, yScale %d, width %d, height %d, alignment %d\n", what, xScale, yScale, width, height, alignment); }
+}
+
+// Bytes after the end of the output must keep the guard value
+static int guardIntact(unsigned char* buffer, int size)
+{
+	for (int i = 0; i < GUARD; i++)
+	{
+		if (buffer[size + i] != GUARD_BYTE) { return 0; }
+	}
+	return 1;
+}
+
+// scaleLineSW and the vector kernel of every factor on their own, for every width and source and destination alignment
+static void checkLines(unsigned char* source)
+{
+	static unsigned char reference[4 * MAX_LONG_WIDTH + GUARD];
+	static unsigned char buffer[ALIGNMENTS + 4 * MAX_LONG_WIDTH + GUARD];
+
+	for (int s = 0; s < 8; s++)
+	{
+		int xScale = validScales[s];
+		SIMDLineKernel simd = simdLineKernel(xScale);
+
+		for (int width = 1; width <= MAX_LONG_WIDTH; width++)
+		{
+			for (int a = 0; a < ALIGNMENTS; a++)
+			{
+				unsigned char* line = &source[a];
+				unsigned char* destination = &buffer[(a * 7) % ALIGNMENTS];
+				int size = scaledSize(width, xScale);
+
+				scaleLineReference(line, reference, width, xScale);
+
+				memset(buffer, GUARD_BYTE, sizeof(buffer));
+				scaleLineSW(line, destination, width, xScale);
+				if (memcmp(reference, destination, size) != 0 || !guardIntact(destination, size)) { fail("scaleLineSW", xScale, 1, width, 1, a); }
+
+				if (simd == NULL) { continue; }
+
+				// Vector kernels take a prefix of whole blocks, downscaling ones a multiple of the factor
+				memset(buffer, GUARD_BYTE, sizeof(buffer));
+				int done = simd(line, destination, width);
+				int doneSize = scaledSize(done, xScale);
+				if (done < 0 || done > width || (xScale < 0 && done % -xScale != 0)) { fail("Vector kernel length", xScale, 1, width, 1, a); continue; }
+				if (memcmp(reference, destination, doneSize) != 0 || !guardIntact(destination, doneSize)) { fail("Vector kernel", xScale, 1, width, 1, a); }
+			}
+		}
+	}
+}
+
+// Frame kernels of every factor pair on regions starting at every alignment of a source with odd stride
+static void checkFrames(unsigned char* source, int sourceWidth)
+{
+	int heights[] = {1, 2, 3, 5, 8};
+	static unsigned char reference[4 * MAX_WIDTH * 4 * 8 + GUARD];
+	static unsigned char destination[4 * MAX_WIDTH * 4 * 8 + GUARD];
+
+	for (int xs = 0; xs < 8; xs++)
+	{
+		for (int ys = 0; ys < 8; ys++)
+		{
+			int xScale = validScales[xs];
+			int yScale = validScales[ys];
+
+			for (int width = 1; width <= MAX_WIDTH; width++)
+			{
+				for (int h = 0; h < 5; h++)
+				{
+					int height = heights[h];
+					int destinationWidth  = scaledSize(width, xScale);
+					int destinationHeight = scaledSize(height, yScale);
+					int size = destinationWidth * destinationHeight;
+
+					for (int a = 0; a < ALIGNMENTS; a++)
+					{
+						// Region at x = a of line a, so both the column and the line start move the alignment
+						for (int j = 0; j < destinationHeight; j++)
+						{
+							int i = yScale > 0 ? j / yScale : j * -yScale;
+							scaleLineReference(&source[PIXEL(a, a + i, sourceWidth)], &reference[PIXEL(0, j, destinationWidth)], width, xScale);
+						}
+
+						memset(destination, GUARD_BYTE, sizeof(destination));
+						scaleSW(source, destination, sourceWidth, a + height, a, a, width, height, destinationWidth, destinationHeight, xScale, yScale);
+						if (memcmp(reference, destination, size) != 0 || !guardIntact(destination, size)) { fail("scaleSW", xScale, yScale, width, height, a); }
+					}
+				}
+			}
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	// Odd stride, so consecutive lines start at different alignments
+	int sourceWidth = ALIGNMENTS + MAX_LONG_WIDTH + 1;
+	int sourceHeight = ALIGNMENTS + 8 * 4;
+	unsigned char* source = malloc(sourceWidth * sourceHeight);
+	if (source == NULL) { printf("Failed to allocate buffers\n"); return 1; }
+
+	srand(1);
+	for (int i = 0; i < sourceWidth * sourceHeight; i++) { source[i] = rand(); }
+
+	char* level = getenv("HOST_SW_SIMD");
+	printf("Checking SW kernels, vector level %s\n", level != NULL ? level : "best");
+
+	checkLines(source);
+	checkFrames(source, sourceWidth);
+
+	free(source);
+
+	if (errors > 0) { printf("%d checks failed\n", errors); return 1; }
+	printf("All checks passed\n");
+	return 0;
+}